@@ -0,0 +1 @@
+name = 'host.py'
@@ -0,0 +1,12 @@
+from argparse import ArgumentParser
+
+from .host import main
+
+# Program entry point for module
+if __name__ == "__main__":
+    parser = ArgumentParser(prog='host', description='Builds the RTOS for the host against stub registers and runs the tests in host/tests.')
+    parser.add_argument('tests',     nargs='*', help='names of the tests to run (default all)')
+    parser.add_argument('--cxx',     default='g++', help='host C++ compiler (default g++)')
+    parser.add_argument('--keep',    action='store_true', help='keep the build directory')
+    parser.add_argument('--verbose', '-v', action='store_true', help='show the output of passing tests')
+    main(parser.parse_args())
@@ -0,0 +1,107 @@
+from sys        import stderr, exit
+from os         import listdir
+from os.path    import abspath, dirname, join, splitext
+from re         import compile, MULTILINE
+from shutil     import copytree, rmtree
+from subprocess import run, PIPE, STDOUT, TimeoutExpired
+from tempfile   import mkdtemp
+
+HOST     = dirname(abspath(__file__))
+ROOT     = dirname(HOST)
+STUBS    = join(HOST, 'stubs')
+TESTS    = join(HOST, 'tests')
+INCLUDES = join(ROOT, 'includes', 'rtos')
+SOURCES  = join(ROOT, 'src', 'rtos')
+HEAP     = 16384 # Pointers take four times the bytes on a 64 bit host
+TIMEOUT  = 20    # Seconds a test may run
+
+# The integer types of RTOS.h, with their AVR widths
+TYPES = {
+    'u8': 'uint8_t', 'u16': 'uint16_t', 'u32': 'uint32_t', 'u64': 'uint64_t',
+    'i8': 'int8_t',  'i16': 'int16_t',  'i32': 'int32_t',  'i64': 'int64_t',
+}
+TYPEDEF = compile(r'^typedef\s+[\w ]+?\s+(\w+);', MULTILINE)
+CONF    = compile(r'^// conf:(.*)$', MULTILINE)
+INCLUDE = compile(r'^#include\s+"[./]*src/rtos/(\w+\.cpp)"', MULTILINE)
+
+# Returns the configurations a test runs in, one per `// conf:` line listing
+# comma separated defines (NAME or NAME=VALUE). No line means the default one
+def variants(source):
+    lines = CONF.findall(source)
+    if not lines:
+        return [[]]
+    return [[define.strip() for define in line.split(',') if define.strip()] for line in lines]
+
+# Copies the headers to `build` with AVR integer widths, a larger virtual heap
+# and the `defines` of the test added to Conf.h
+def configure(build, defines):
+    headers = join(build, 'rtos')
+    copytree(INCLUDES, headers)
+    def edit(name, change):
+        path = join(headers, name)
+        with open(path) as file:
+            text = file.read()
+        with open(path, 'w') as file:
+            file.write(change(text))
+    edit('RTOS.h', lambda text: TYPEDEF.sub(
+        lambda match: f'typedef {TYPES[match.group(1)]} {match.group(1)};' if match.group(1) in TYPES else match.group(0), 
+        text
+    ))
+    edit('CheckConf.h', lambda text: text.replace('RTOS_VIRTUAL_HEAP > 4096', f'RTOS_VIRTUAL_HEAP > {HEAP}'))
+    lines = [f'#undef RTOS_VIRTUAL_HEAP', f'#define RTOS_VIRTUAL_HEAP {HEAP}']
+    for define in defines:
+        name, _, value = define.partition('=')
+        lines += [f'#undef {name}', f'#define {name} {value}'.rstrip()]
+    edit('Conf.h', lambda text: text.replace('#endif /* RTOS_CONF */', '\n'.join(lines) + '\n\n#endif /* RTOS_CONF */'))
+    return headers
+
+# Builds and runs one configuration of a test, returns its output or None if
+# it passed
+def check(args, build, test, source, defines):
+    headers  = configure(build, defines)
+    included = set(INCLUDE.findall(source))
+    sources  = [join(SOURCES, name) for name in sorted(listdir(SOURCES)) if name.endswith('.cpp') and name not in included]
+    binary   = join(build, 'test')
+    command  = [
+        args.cxx, '-std=c++11', '-g', '-Wall', '-fsanitize=address,undefined',
+        '-I', STUBS, '-I', headers, '-I', SOURCES,
+        *sources, join(STUBS, 'Host.cpp'), test, '-o', binary,
+    ]
+    result = run(command, stdout=PIPE, stderr=STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        return result.stdout
+    try:
+        result = run([binary], stdout=PIPE, stderr=STDOUT, universal_newlines=True, timeout=TIMEOUT)
+    except TimeoutExpired as timeout:
+        return (timeout.output or '') + f'\nTimed out after {TIMEOUT} s'
+    if result.returncode != 0:
+        return result.stdout + f'\nExited with {result.returncode}'
+    if args.verbose:
+        print(result.stdout, end='')
+    return None
+
+def main(args):
+    names = sorted(splitext(name)[0] for name in listdir(TESTS) if name.endswith('.cpp'))
+    for name in args.tests:
+        if name not in names:
+            print(f'No test named {name}', file=stderr)
+            exit(1)
+    failed = 0
+    for name in args.tests or names:
+        test = join(TESTS, name + '.cpp')
+        with open(test) as file:
+            source = file.read()
+        for defines in variants(source):
+            build  = mkdtemp(prefix=f'rtos-{name}-')
+            label  = f'{name} [{", ".join(defines) or "default"}]'
+            output = check(args, build, test, source, defines)
+            if output is None:
+                print(f'PASS {label}')
+            else:
+                failed += 1
+                print(f'FAIL {label}\n{output}')
+            if args.keep:
+                print(f'Kept {build}', file=stderr)
+            else:
+                rmtree(build, ignore_errors=True)
+    exit(1 if failed else 0)
@@ -0,0 +1,29 @@
+#pragma once
+
+// The parts of the Arduino core the RTOS uses
+
+#include <stdint.h>
+
+#define HIGH        1
+#define LOW         0
+#define OUTPUT      1
+#define LED_BUILTIN 13
+
+template <class A, class B> 
+auto min(A a, B b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+
+template <class A, class B> 
+auto max(A a, B b) -> decltype(a < b ? a : b) { return a > b ? a : b; }
+
+void init_arduino();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+struct HardwareSerial {
+    void begin(long baud);
+    void write(uint8_t byte);
+    void print(const char * string);
+    void flush();
+};
+
+extern HardwareSerial Serial;
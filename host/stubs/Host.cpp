@@ -0,0 +1,61 @@
+#include "Host.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+// Registers
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, OCR1C;
+volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, ASSR, TCNT2, OCR2A;
+volatile uint8_t TIMSK0, TIFR0;
+volatile uint8_t WDTCSR, MCUSR, SREG, SPL, SPH;
+volatile uint16_t SP;
+
+// Arduino
+extern "C" volatile unsigned long timer0_millis = 0;
+extern "C" volatile unsigned long timer0_overflow_count = 0;
+HardwareSerial Serial;
+
+void init_arduino() {}
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+void HardwareSerial::begin(long) {}
+void HardwareSerial::write(uint8_t) {}
+void HardwareSerial::print(const char *) {}
+void HardwareSerial::flush() {}
+
+int host_sleep_mode = SLEEP_MODE_IDLE;
+
+extern "C" void host_sleep(void) {
+    Host::sleep();
+}
+
+namespace Host {
+
+    void tick(u16 ms) {
+        for (u16 i = 0; i < ms; i++) {
+            TCNT1 = 0;
+            TIMER1_COMPA_vect();
+        }
+    }
+
+    static void tick_once() {
+        tick(1);
+    }
+
+    void (*sleep)() = tick_once;
+
+    void expect(bool condition, const char * fmt, ...) {
+        if (condition) {
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+        fputc('\n', stderr);
+        exit(1);
+    }
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Helpers for the host tests. A test is a program that runs the RTOS on the 
+// host against the stub registers, exits with 0 (RTOS::halt does) when it 
+// passes and with 1 through Host::expect when it does not
+
+#include <RTOS.h>
+#include <Private.h>
+
+extern "C" void TIMER1_COMPA_vect(void);
+
+namespace Host {
+
+    /**
+     * Advances the clock by `ms` milliseconds, one timer1 compare A 
+     * interrupt at a time, as if the processor had been busy.
+     * 
+     * @param u16 ms the milliseconds to advance
+     */
+    void tick(u16 ms = 1);
+
+    /**
+     * Called in place of every sleep. Ticks once by default, a test may 
+     * replace it to simulate other interrupts.
+     */
+    extern void (*sleep)();
+
+    /**
+     * Fails the test with a printf style message unless `condition` holds.
+     * 
+     * @param bool         condition what the test expects
+     * @param const char * fmt       the failure message format
+     */
+    void expect(bool condition, const char * fmt, ...);
+
+}
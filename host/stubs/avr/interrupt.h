@@ -0,0 +1,8 @@
+#pragma once
+
+// Interrupts are plain functions the tests call to simulate the hardware
+
+#define ISR(vector, ...) extern "C" void vector(void)
+#define sei()
+#define cli()
+#define reti()
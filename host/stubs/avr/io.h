@@ -0,0 +1,55 @@
+#pragma once
+
+// The registers the RTOS touches, plain variables defined in Host.cpp. Bit 
+// numbers match the ATmega2560 where the RTOS depends on them
+
+#include <stdint.h>
+
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, OCR1C;
+extern volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, ASSR, TCNT2, OCR2A;
+extern volatile uint8_t TIMSK0, TIFR0;
+extern volatile uint8_t WDTCSR, MCUSR, SREG, SPL, SPH;
+extern volatile uint16_t SP;
+
+#define RAMEND 0x21FF
+#define _BV(bit) (1 << (bit))
+
+// Timer0
+#define TOIE0 0
+#define TOV0  0
+
+// Timer1
+#define CS10   0
+#define CS11   1
+#define CS12   2
+#define WGM12  3
+#define OCIE1A 1
+#define OCIE1B 2
+#define OCIE1C 3
+#define OCF1A  1
+#define OCF1B  2
+#define OCF1C  3
+
+// Timer2
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define WGM21   1
+#define OCIE2A  1
+#define OCF2A   1
+#define AS2     5
+#define TCN2UB  4
+#define OCR2AUB 3
+#define TCR2AUB 1
+#define TCR2BUB 0
+
+// Watchdog
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE  3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDRF 3
@@ -0,0 +1,8 @@
+#pragma once
+
+// There is one address space on the host
+
+#define PROGMEM
+#define pgm_read_byte(p)  (*(const uint8_t *) (p))
+#define pgm_read_word(p)  (*(const uint16_t *) (p))
+#define pgm_read_dword(p) (*(const uint32_t *) (p))
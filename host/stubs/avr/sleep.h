@@ -0,0 +1,17 @@
+#pragma once
+
+// Sleeping calls Host::sleep, which stands in for the time that passes
+
+#define SLEEP_MODE_IDLE        0
+#define SLEEP_MODE_PWR_SAVE    1
+#define SLEEP_MODE_PWR_DOWN    2
+#define SLEEP_MODE_EXT_STANDBY 3
+
+extern "C" void host_sleep(void);
+extern int host_sleep_mode;
+
+#define set_sleep_mode(mode) (host_sleep_mode = (mode))
+#define sleep_mode()         host_sleep()
+#define sleep_cpu()          host_sleep()
+#define sleep_enable()
+#define sleep_disable()
@@ -0,0 +1,3 @@
+#pragma once
+
+#define wdt_reset()
@@ -0,0 +1,9 @@
+#pragma once
+
+// Interrupts only happen when a test calls them, so every block is atomic
+
+#define ATOMIC_RESTORESTATE    0
+#define ATOMIC_FORCEON         1
+#define NONATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type)    for (int atomic_once = 1; atomic_once; atomic_once = 0)
+#define NONATOMIC_BLOCK(type) for (int atomic_once = 1; atomic_once; atomic_once = 0)
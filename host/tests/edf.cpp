@@ -0,0 +1,109 @@
+// Runs a task set that meets every deadline under RTOS_EDF but not in plain
+// release order. With HOST_TIGHT_DEADLINE one deadline cannot be met, and 
+// every miss must be traced as Error_Deadline
+// conf:
+// conf: RTOS_EDF
+// conf: RTOS_EDF, HOST_TIGHT_DEADLINE
+
+#include <Host.h>
+
+using namespace RTOS;
+
+static const Time_t RUN = 1000; // How long to run for (ms)
+
+struct Spec_t {
+    const char * name;
+    u16 period;
+    u16 delay;
+    u16 cost;     // Simulated runtime (ms)
+    u16 deadline; // Relative to the release (ms)
+    u16 runs;
+    u16 late;
+};
+
+// Utilization 0.75, but "a" and "d" are released behind longer tasks
+static Spec_t specs[] = {
+    { "c", 20, 0, 3, 20, 0, 0 },
+    { "b", 20, 1, 6, 20, 0, 0 },
+    #ifdef HOST_TIGHT_DEADLINE
+    { "a", 20, 2, 2, 1,  0, 0 },
+    #else
+    { "a", 20, 2, 2, 5,  0, 0 },
+    #endif
+    { "d", 10, 4, 2, 6,  0, 0 },
+};
+
+static const u8 SPECS = sizeof(specs) / sizeof(specs[0]);
+
+static Task_t * tasks[SPECS];
+static u16 traced = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {}
+
+    bool error(Trace_t * trace) {
+        // A late run may also start after its next release
+        Host::expect(
+            trace->tag == Error_Deadline || trace->tag == Error_Missed, 
+            "unexpected error %d", trace->tag
+        );
+        if (trace->tag == Error_Deadline) {
+            traced++;
+        }
+        return true;
+    }
+
+}}
+
+static void finish() {
+    u16 late = 0;
+    for (Spec_t & spec : specs) {
+        printf("%s ran %u times, %u late\n", spec.name, spec.runs, spec.late);
+        late += spec.late;
+    }
+    #if defined(RTOS_EDF) && defined(HOST_TIGHT_DEADLINE)
+    Host::expect(specs[2].late == specs[2].runs && late == specs[2].late, "expected only every run of a late, %u were", late);
+    #elif defined(RTOS_EDF)
+    Host::expect(late == 0, "%u runs were late under EDF", late);
+    #else
+    // Release order runs "b" before "a", and "a" before "d"
+    Host::expect(specs[2].late > 0 && specs[3].late > 0, "expected a and d to be late in release order");
+    #endif
+    #ifdef RTOS_EDF
+    Host::expect(traced == late, "%u late runs but %u Error_Deadline traces", late, traced);
+    #endif
+    halt();
+}
+
+static bool work(Task_t * self) {
+    u8 i = 0;
+    while (tasks[i] != self) {
+        i++;
+    }
+    Spec_t * spec = &specs[i];
+    Host::tick(spec->cost);
+    Time_t due = spec->delay + (Time_t) spec->period * spec->runs++ + spec->deadline;
+    if (Time::now() > due) {
+        spec->late++;
+    }
+    if (Time::now() >= RUN) {
+        finish();
+    }
+    return true;
+}
+
+int main() {
+    init();
+    for (u8 i = 0; i < SPECS; i++) {
+        Task_t * task = Task::init(specs[i].name, work);
+        task->period_ms = specs[i].period;
+        task->delay_ms  = specs[i].delay;
+        #ifdef RTOS_EDF
+        task->deadline_ms = specs[i].deadline;
+        #endif
+        tasks[i] = task;
+        Task::dispatch(task);
+    }
+    dispatch();
+}
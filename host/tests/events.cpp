@@ -0,0 +1,75 @@
+// Dispatches one event to three subscribers, each must run once per dispatch.
+// An event dispatched while no task listens is kept for the first that does
+// conf:
+// conf: RTOS_EDF
+
+#include <Host.h>
+
+using namespace RTOS;
+
+static const u8 SUBSCRIBERS = 3;
+static const u8 DISPATCHES = 5;
+
+static Event_t shared;
+static Event_t early;
+static u8 runs[SUBSCRIBERS];
+static u8 early_runs = 0;
+static u8 dispatches = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {}
+
+    bool error(Trace_t * trace) {
+        Host::expect(false, "unexpected error %d", trace->tag);
+        return true;
+    }
+
+}}
+
+static bool subscriber(Task_t * self) {
+    runs[(u8) (uintptr_t) self->state]++;
+    return true;
+}
+
+static bool late(Task_t * self) {
+    early_runs++;
+    return true;
+}
+
+// Dispatches the shared event every 10 ms, then checks every subscriber saw
+// each one exactly once
+static bool source(Task_t * self) {
+    for (u8 i = 0; i < SUBSCRIBERS; i++) {
+        Host::expect(runs[i] == dispatches, "subscriber %u ran %u times for %u events", i, runs[i], dispatches);
+    }
+    if (dispatches == DISPATCHES) {
+        Host::expect(early_runs == 1, "the kept event ran its late subscriber %u times", early_runs);
+        halt();
+    }
+    if (dispatches == 1) {
+        Task_t * task = Task::init("late", late);
+        task->events = early;
+        Task::dispatch(task);
+    }
+    Event::dispatch(shared);
+    dispatches++;
+    return true;
+}
+
+int main() {
+    init();
+    shared = Event::init("shared");
+    early  = Event::init("early");
+    Event::dispatch(early);
+    for (u8 i = 0; i < SUBSCRIBERS; i++) {
+        Task_t * task = Task::init("subscriber", subscriber);
+        task->state  = (void *) (uintptr_t) i;
+        task->events = shared;
+        Task::dispatch(task);
+    }
+    Task_t * task = Task::init("source", source);
+    task->period_ms = 10;
+    Task::dispatch(task);
+    dispatch();
+}
@@ -0,0 +1,41 @@
+// Allocates and frees heap blocks with every check enabled. Freeing nullptr
+// must do nothing, and a freed block must be merged back for reuse
+// conf: RTOS_HEAP, RTOS_CHECK_ALL
+
+#include <Host.h>
+
+using namespace RTOS;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {}
+
+    bool error(Trace_t * trace) {
+        Host::expect(false, "unexpected error %d", trace->tag);
+        return true;
+    }
+
+}}
+
+static bool heap(Task_t * self) {
+    u16 available = Memory::Heap::available();
+
+    Memory::Heap::free(nullptr);
+    Host::expect(Memory::Heap::available() == available, "freeing nullptr changed the heap");
+
+    void * a = Memory::Heap::alloc(100);
+    void * b = Memory::Heap::alloc(200);
+    Host::expect(a != nullptr && b != nullptr, "could not allocate");
+    Memory::Heap::free(a);
+    Memory::Heap::free(b);
+    Host::expect(Memory::Heap::available() == available, "%u of %u bytes free after freeing all", Memory::Heap::available(), available);
+
+    halt();
+    return false;
+}
+
+int main() {
+    init();
+    Task::dispatch(Task::init("heap", heap));
+    dispatch();
+}
@@ -0,0 +1,62 @@
+// Runs two periodic tasks released at the same time. The first runs for 3 ms,
+// so the second must report starting 3000 us after its release
+// conf: RTOS_LATCH
+
+#include <Host.h>
+
+using namespace RTOS;
+
+static const u16 COST = 3; // Runtime of the first task (ms)
+
+static Task_t * first;
+static Task_t * second;
+static u16 starts = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {
+        if (trace->tag == Mark_Init) {
+            Host::expect(trace->mark.init.latency, "the init trace does not report latency");
+        }
+        if (trace->tag != Mark_Start) {
+            return;
+        }
+        u16 latency = trace->mark.start.latency;
+        if (trace->mark.start.instance == first->impl.instance) {
+            Host::expect(latency == 0, "the first task started %u us late", latency);
+        } else {
+            Host::expect(latency == COST * 1000, "the second task started %u us late, not %u", latency, COST * 1000);
+        }
+        starts++;
+    }
+
+    bool error(Trace_t * trace) {
+        // Starting after the release millisecond is traced as a miss
+        Host::expect(trace->tag == Error_Missed, "unexpected error %d", trace->tag);
+        return true;
+    }
+
+}}
+
+static bool busy(Task_t * self) {
+    Host::tick(COST);
+    return true;
+}
+
+static bool check(Task_t * self) {
+    if (starts >= 20) {
+        halt();
+    }
+    return true;
+}
+
+int main() {
+    init();
+    first = Task::init("busy", busy);
+    first->period_ms = 10;
+    Task::dispatch(first);
+    second = Task::init("check", check);
+    second->period_ms = 10;
+    Task::dispatch(second);
+    dispatch();
+}
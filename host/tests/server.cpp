@@ -0,0 +1,59 @@
+// Runs an event task that overruns the server budget on every run. Its debt
+// must be paid back from later budgets, keeping it to budget / period of the
+// processor however long each run takes
+// conf: RTOS_SERVER, RTOS_SERVER_BUDGET_US=2000, RTOS_SERVER_PERIOD_MS=10
+
+#include <Host.h>
+
+using namespace RTOS;
+
+static const Time_t START = 40;  // When to start counting (ms)
+static const Time_t STOP  = 540; // When to stop counting (ms)
+static const u16 COST     = 30;  // Runtime of every handler run (ms)
+
+static Event_t work;
+static u32 busy = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {}
+
+    bool error(Trace_t * trace) {
+        Host::expect(false, "unexpected error %d", trace->tag);
+        return true;
+    }
+
+}}
+
+// Every millisecond is also an interrupt that dispatches more work
+static void tick() {
+    Host::tick();
+    Event::dispatch(work);
+}
+
+static bool handler(Task_t * self) {
+    if (Time::now() >= STOP) {
+        u32 share = busy * 100 / (STOP - START);
+        printf("event tasks took %lu%% of the processor\n", (unsigned long) share);
+        Host::expect(share <= 20, "the server allows 20%%, event tasks took %lu%%", (unsigned long) share);
+        halt();
+    }
+    if (Time::now() >= START) {
+        busy += COST;
+    }
+    for (u16 i = 0; i < COST; i++) {
+        tick();
+    }
+    return true;
+}
+
+int main() {
+    init();
+    Host::sleep = tick;
+    work = Event::init("work");
+    Task_t * task = Task::init("handler", handler);
+    task->events = work;
+    Task::dispatch(task);
+    Event::dispatch(work);
+    dispatch();
+}
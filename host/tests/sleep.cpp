@@ -0,0 +1,62 @@
+// Runs a periodic task that leaves the processor idle for most of each
+// period, so it sleeps in power-save with Timer2. The clock must keep up with
+// the time slept, including the oscillator start up on each wakeup
+// conf: RTOS_DEEP_SLEEP, RTOS_SLEEP_TIMER2
+
+#include <Host.h>
+
+using namespace RTOS;
+
+static const u16 PERIOD = 1000; // Period of the task (ms)
+static const u16 RUNS = 20;     // How many periods to run for
+
+// The time that has really passed in 1/32 ms, as Timer2 ticks are 125/32 ms
+static u32 real = 0;
+static u16 runs = 0;
+static u16 deep_sleeps = 0;
+
+// Sleeps until Timer2 matches and the 1 ms oscillator start up has passed,
+// timer1 stops meanwhile. Any other sleep lasts one timer1 tick.
+static void sleep() {
+    if (host_sleep_mode == SLEEP_MODE_PWR_SAVE) {
+        real += ((u32) OCR2A + 1) * 125 + 32;
+        TCNT2 = 0;
+        TIFR2 = BV(OCF2A);
+        deep_sleeps++;
+    } else {
+        real += 32;
+        Host::tick();
+    }
+}
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {
+        Host::expect(trace->tag < Error_Max_Event || trace->tag >= Debug_Message, "error %u", trace->tag);
+    }
+
+    bool error(Trace_t * trace) {
+        Host::expect(false, "error %u", trace->tag);
+        return true;
+    }
+
+}}
+
+static bool periodic(Task_t * self) {
+    long drift = (long) Time::now() - (long) (real / 32);
+    Host::expect(drift >= -1 && drift <= 1, "the clock is %ld ms off after %u runs", drift, runs);
+    if (++runs == RUNS) {
+        Host::expect(deep_sleeps >= RUNS - 1, "only %u deep sleeps", deep_sleeps);
+        halt();
+    }
+    return true;
+}
+
+int main() {
+    Host::sleep = sleep;
+    init();
+    Task_t * task = Task::init("periodic", periodic);
+    task->period_ms = PERIOD;
+    Task::dispatch(task);
+    dispatch();
+}
@@ -0,0 +1,64 @@
+// Allocates every chunk of a static pool from a static constructor, before
+// RTOS::init, then frees and reuses them. Freeing nullptr must only be traced
+
+#include <Host.h>
+
+using namespace RTOS;
+
+struct Reading_t {
+    u32 time;
+    u16 value;
+};
+
+const char readings_handle[] = "readings";
+static Memory::Static_Pool_t<Reading_t, 4, readings_handle> readings;
+
+static Reading_t * early[4];
+static u16 null_errors = 0;
+static u16 max_errors = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {}
+
+    bool error(Trace_t * trace) {
+        if (trace->tag == Error_Null_Pool) {
+            null_errors++;
+        } else if (trace->tag == Error_Max_Pool) {
+            max_errors++;
+        } else {
+            Host::expect(false, "unexpected error %d", trace->tag);
+        }
+        return true;
+    }
+
+}}
+
+// Runs before main, the pool must already be usable
+static struct Early_t {
+    Early_t() {
+        for (Reading_t * & reading : early) {
+            reading = readings.alloc();
+        }
+    }
+} early_alloc;
+
+int main() {
+    init();
+    for (u8 i = 0; i < 4; i++) {
+        Host::expect(early[i] != nullptr, "chunk %u was not allocated", i);
+        for (u8 j = 0; j < i; j++) {
+            Host::expect(early[i] != early[j], "chunks %u and %u are the same", i, j);
+        }
+        early[i]->time  = i;
+        early[i]->value = i;
+    }
+    Host::expect(readings.alloc() == nullptr && max_errors == 1, "a fifth chunk was allocated");
+
+    readings.dealloc(early[2]);
+    readings.dealloc(nullptr);
+    Host::expect(null_errors == 1, "freeing nullptr was not traced");
+    Host::expect(readings.alloc() == early[2], "a freed chunk was not reused");
+    Host::expect(early[3]->value == 3, "a chunk in use was overwritten");
+    halt();
+}
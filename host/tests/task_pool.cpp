@@ -0,0 +1,50 @@
+// Takes chunks from the task pool, which must only claim virtual heap for as
+// many tasks as have been alive at once, up to RTOS_MAX_TASKS
+
+#include <Host.h>
+
+#include <string.h>
+
+using namespace RTOS;
+
+static const char * HANDLE = "RTOS::Registers::task_pool";
+
+static u16 allocs = 0; // Virtual heap allocations made for the task pool
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {
+        if (trace->tag == Def_Alloc && strcmp(trace->def.alloc.handle, HANDLE) == 0) {
+            allocs++;
+        }
+    }
+
+    bool error(Trace_t * trace) {
+        Host::expect(false, "unexpected error %d", trace->tag);
+        return true;
+    }
+
+}}
+
+int main() {
+    init();
+    Host::expect(allocs == 1, "the task pool took %u allocations before any task", allocs);
+
+    void * tasks[RTOS_MAX_TASKS];
+    for (u8 i = 0; i < 3; i++) {
+        tasks[i] = Memory::Pool::alloc(Registers::task_pool);
+    }
+    Host::expect(allocs == 4, "3 tasks took %u allocations", allocs - 1);
+
+    Memory::Pool::dealloc(Registers::task_pool, tasks[1]);
+    Host::expect(Memory::Pool::alloc(Registers::task_pool) == tasks[1], "a freed task was not reused");
+    Host::expect(allocs == 4, "reusing a task took another allocation");
+
+    for (u8 i = 3; i < RTOS_MAX_TASKS; i++) {
+        tasks[i] = Memory::Pool::alloc(Registers::task_pool);
+        Host::expect(tasks[i] != nullptr, "task %u was not allocated", i);
+    }
+    Host::expect(allocs == 1 + RTOS_MAX_TASKS, "%u tasks took %u allocations", RTOS_MAX_TASKS, allocs - 1);
+
+    halt();
+}
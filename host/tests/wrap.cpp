@@ -0,0 +1,83 @@
+// Runs two periodic tasks across the 2^32 millisecond wrap of the 32 bit 
+// clock, every release must still come exactly one period after the last
+// conf: RTOS_TIME_32
+
+#include <Host.h>
+
+// Included for the clock, so the test can start it just before the wrap
+#include "../../src/rtos/Time.cpp"
+
+using namespace RTOS;
+
+static const Time_t START = (Time_t) -100; // 100 ms before the wrap
+static const Time_Delta_t RUN = 200;       // How long to run for (ms)
+
+struct Periodic_t {
+    const char * name;
+    u16 period;
+    u16 delay;
+    u16 runs;
+    Time_t last;
+};
+
+static Periodic_t periodics[] = {
+    { "fast", 10, 0, 0, 0 },
+    { "slow", 15, 3, 0, 0 },
+};
+
+static u16 errors = 0;
+
+namespace RTOS { namespace UDF {
+
+    void trace(Trace_t * trace) {
+        if (trace->tag >= Error_Max_Event && trace->tag < Debug_Message) {
+            errors++;
+        }
+    }
+
+    bool error(Trace_t * trace) {
+        errors++;
+        return true;
+    }
+
+}}
+
+static bool periodic(Task_t * self) {
+    Periodic_t * p = &periodics[self->period_ms == 10 ? 0 : 1];
+    Time_t now = Time::now();
+    if (p->runs++ > 0) {
+        Host::expect(
+            (Time_Delta_t) (now - p->last) == p->period, 
+            "%s released %ld ms after its last release at %lu", 
+            p->name, (long) (Time_Delta_t) (now - p->last), (unsigned long) p->last
+        );
+    }
+    p->last = now;
+    if ((Time_Delta_t) (now - START) >= RUN) {
+        Host::expect(errors == 0, "%u errors", errors);
+        Host::expect((Time_Delta_t) (now - START) < RUN + 10, "stopped %ld ms late", (long) (Time_Delta_t) (now - START - RUN));
+        Host::expect(periodics[0].runs >= 19 && periodics[1].runs >= 12, "only %u and %u runs", periodics[0].runs, periodics[1].runs);
+        halt();
+    }
+    return true;
+}
+
+// Moves the clock to START, then dispatches the periodic tasks
+static bool warp(Task_t * self) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        Time::timer1_millis = START;
+    }
+    for (Periodic_t & p : periodics) {
+        Task_t * task = Task::init(p.name, periodic);
+        task->period_ms = p.period;
+        task->delay_ms  = p.delay;
+        Task::dispatch(task);
+    }
+    return false;
+}
+
+int main() {
+    init();
+    Task::dispatch(Task::init("warp", warp));
+    dispatch();
+}
@@ -27,4 +27,59 @@
 #include <FORCE STOP>
 #endif
 
+#if defined(RTOS_DEEP_SLEEP) && (!defined(RTOS_SLEEP_LATENCY_MS) || RTOS_SLEEP_LATENCY_MS < 0)
+#error RTOS Configuration Error: define RTOS_SLEEP_LATENCY_MS with a value greater than or equal to 0
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_DEEP_SLEEP) && !defined(RTOS_SLEEP_TIMER2) && (!defined(RTOS_SLEEP_WATCHDOG_MS) || RTOS_SLEEP_WATCHDOG_MS < 16 || RTOS_SLEEP_WATCHDOG_MS > 8192 || (RTOS_SLEEP_WATCHDOG_MS & (RTOS_SLEEP_WATCHDOG_MS - 1)))
+#error RTOS Configuration Error: define RTOS_SLEEP_WATCHDOG_MS as a power of two between 16 and 8192
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_PREEMPT) && (!defined(RTOS_PREEMPT_TASKS) || RTOS_PREEMPT_TASKS < 1 || RTOS_PREEMPT_TASKS > 16)
+#error RTOS Configuration Error: define RTOS_PREEMPT_TASKS with a value between 1 and 16
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_PREEMPT) && (!defined(RTOS_PREEMPT_STACK) || RTOS_PREEMPT_STACK < 64 || RTOS_PREEMPT_STACK > 255)
+#error RTOS Configuration Error: define RTOS_PREEMPT_STACK with a value between 64 and 255
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_PREEMPT) && (defined(RTOS_TICKLESS) || defined(RTOS_DEEP_SLEEP))
+#error RTOS Configuration Error: RTOS_PREEMPT needs the millisecond tick, undefine RTOS_TICKLESS and RTOS_DEEP_SLEEP
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_EDF) && defined(RTOS_PREEMPT)
+#error RTOS Configuration Error: RTOS_EDF and RTOS_PREEMPT are different scheduling policies, define only one
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_BUDGET) && defined(RTOS_PREEMPT)
+#error RTOS Configuration Error: RTOS_BUDGET can only time run-to-completion tasks, undefine RTOS_PREEMPT
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_SERVER) && (RTOS_SERVER_PERIOD_MS < 1 || RTOS_SERVER_BUDGET_US < 1 || RTOS_SERVER_BUDGET_US > RTOS_SERVER_PERIOD_MS * 1000L)
+#error RTOS Configuration Error: define RTOS_SERVER_BUDGET_US with a value between 1 and RTOS_SERVER_PERIOD_MS * 1000
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_HEAP) && (RTOS_HEAP_BYTES < 64 || RTOS_HEAP_BYTES > RTOS_VIRTUAL_HEAP)
+#error RTOS Configuration Error: define RTOS_HEAP_BYTES with a value between 64 and RTOS_VIRTUAL_HEAP
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_SCRATCH) && (RTOS_SCRATCH_BYTES < 1 || RTOS_SCRATCH_BYTES > RTOS_VIRTUAL_HEAP)
+#error RTOS Configuration Error: define RTOS_SCRATCH_BYTES with a value between 1 and RTOS_VIRTUAL_HEAP
+#include <FORCE STOP>
+#endif
+
+#if defined(RTOS_FIT_PERCENTILE) && (RTOS_FIT_PERCENTILE < 1 || RTOS_FIT_PERCENTILE > 100)
+#error RTOS Configuration Error: define RTOS_FIT_PERCENTILE with a value between 1 and 100
+#include <FORCE STOP>
+#endif
+
 #endif /* RTOS_CHECK_CONF_H */
\ No newline at end of file
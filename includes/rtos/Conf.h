@@ -10,13 +10,128 @@
 // How much consumable memory the RTOS should provide
 #define RTOS_VIRTUAL_HEAP 2048
 
+// Defining carves a general purpose heap of RTOS_HEAP_BYTES out of the 
+// virtual heap, see Memory::Heap. RTOS_VIRTUAL_HEAP must leave room for it.
+// #define RTOS_HEAP
+#define RTOS_HEAP_BYTES 1024
+
+// Defining reserves RTOS_SCRATCH_BYTES of the virtual heap for temporary 
+// buffers, see Memory::scratch.
+// #define RTOS_SCRATCH
+#define RTOS_SCRATCH_BYTES 256
+
+// Defining paints the free memory between the heap and the stack when the 
+// RTOS is initialized, and scans a little of it during each idle period to 
+// find how deep the stack has reached. See Memory::stack_free.
+// #define RTOS_STACK_PAINT
+
 // The maximum number of definable event. Must be 8, 16, 32, or 64.
 #define RTOS_MAX_EVENTS 64
 
 // The maximum number of tasks that can be instantiated at a given time.
-// Maximum 64.
+// Maximum 64. A task takes about 49 bytes of the virtual heap with the 
+// default options, more with RTOS_EDF, RTOS_FIT_PERCENTILE and the other 
+// per-task features. Only the most tasks alive at once are ever allocated.
 #define RTOS_MAX_TASKS 64
 
+// Defining will cause the RTOS to keep time in 32 bit milliseconds, which
+// wrap around roughly every 49 days. Scheduling remains wraparound safe, but
+// Time::now64 must be used wherever an absolute 64 bit time is needed.
+// #define RTOS_TIME_32
+
+// Defining will cause the RTOS to stop its 1 ms timer tick while idle. Timer1
+// is instead set to interrupt once at the end of the idle period, and any
+// other interrupt that dispatches an event ends the idle early. With 
+// RTOS_USE_ARDUINO the Arduino timer0 overflow interrupt is stopped as well,
+// and millis() and micros() are corrected to within a millisecond after.
+// #define RTOS_TICKLESS
+
+// Defining will let the RTOS use a deeper sleep mode than idle when an idle
+// period is long enough. Timer1 stops in deep sleep, so the RTOS clock is 
+// corrected on wake. By default the watchdog wakes the processor from 
+// power-down. The watchdog oscillator is only accurate to about 10 percent,
+// depending on voltage and temperature, so the clock drifts by as much while
+// powered down. An interrupt that ends a watchdog sleep early cannot be 
+// timed, half of the sleep is charged. If a 32.768 kHz crystal is connected
+// to TOSC1 and TOSC2, define RTOS_SLEEP_TIMER2 to wake from power-save with 
+// Timer2 instead. Its counter is read on wake, so the clock stays within one
+// Timer2 tick (about 4 ms) of the time slept, though the error of several
+// sleeps can add up. Every deep sleep is also charged the 1 ms oscillator 
+// start up. With RTOS_USE_ARDUINO, Serial is flushed before a deep sleep, as
+// the UART stops with the clock.
+// #define RTOS_DEEP_SLEEP
+// #define RTOS_SLEEP_TIMER2
+
+// The longest single watchdog sleep in milliseconds, a power of two between
+// 16 and 8192. Longer idle periods sleep several times. An interrupt that 
+// ends a sleep early costs the clock up to half of this.
+#define RTOS_SLEEP_WATCHDOG_MS 128
+
+// The longest wakeup latency (in milliseconds) a deep sleep may add to an 
+// idle period. Sleep modes that cannot wake up within it are never used.
+#define RTOS_SLEEP_LATENCY_MS 2
+
+// Defining will cause task runtimes and trace timestamps to be measured in
+// microseconds with Time::now_us instead of in milliseconds.
+// #define RTOS_TIME_US
+
+// Defining enables preemptive tasks. A task with a priority greater than 0 
+// runs on its own stack and preempts run-to-completion tasks and lower 
+// priority preemptive tasks as soon as it is released.
+// #define RTOS_PREEMPT
+
+// The maximum number of preemptive tasks that can be dispatched at a given 
+// time.
+#define RTOS_PREEMPT_TASKS 4
+
+// The stack size in bytes of each preemptive task. Maximum 255.
+#define RTOS_PREEMPT_STACK 192
+
+// Defining schedules released tasks by earliest absolute deadline instead of
+// running periodic tasks first, then delayed tasks, then event tasks. See 
+// `deadline_ms` in Task.h.
+// #define RTOS_EDF
+
+// Defining will run an admission test whenever a periodic task is dispatched.
+// The task set is checked against the Liu-Layland utilization bound, then, if
+// that fails, with an exact rate-monotonic response time analysis. A task 
+// that would overload the system is not dispatched. See `wcet_us` in Task.h.
+// #define RTOS_ADMISSION
+
+// Defining enforces the `budget_us` of each task with the timer1 compare B
+// interrupt. A task still running when its budget runs out produces an 
+// overrun error from the interrupt, while the task is still running.
+// #define RTOS_BUDGET
+
+// Defining reports in each task start trace how long after its release the
+// task started (us), the release jitter caused by the tasks run before it.
+// Releases fall on the millisecond tick, so the release instant is known 
+// exactly without a timer compare. No interrupt is added, it does not keep
+// RTOS_TICKLESS from sleeping.
+// #define RTOS_LATCH
+
+// Defining makes event tasks draw their runtime from a deferrable server, a
+// budget of RTOS_SERVER_BUDGET_US replenished every RTOS_SERVER_PERIOD_MS.
+// Once the budget is spent event tasks wait for the next replenishment, and a
+// run that overspends is paid back from as many later budgets as it took, so 
+// they use at most budget / period of the processor and cannot starve delayed
+// tasks. Preemptive event tasks do not draw from the server.
+// #define RTOS_SERVER
+
+// The budget of the event server in microseconds
+#define RTOS_SERVER_BUDGET_US 2000
+
+// The replenishment period of the event server in milliseconds
+#define RTOS_SERVER_PERIOD_MS 10
+
+// Defining keeps a log2 histogram of the runtimes of each task. Delayed and
+// event tasks are then run in an idle gap if the given percentile of their
+// runtimes fits, instead of their maximum runtime.
+// #define RTOS_FIT_PERCENTILE 90
+
+// Defining enables stackless coroutine tasks, see Coroutine.h.
+// #define RTOS_COROUTINE
+
 // Defining will cause RTOS to call RTOS::UDF::trace with trace info
 #define RTOS_TRACE
 
@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef RTOS_COROUTINE_H
+#define RTOS_COROUTINE_H
+
+/**
+ * Stackless coroutine tasks, available if RTOS_COROUTINE is defined. A task
+ * function written between CO_BEGIN and CO_END can give up the processor 
+ * part way through and continue from the same point the next time it is 
+ * run, without needing its own stack. The resume point is kept in the task,
+ * so local variables do NOT survive a suspension, anything that must be kept
+ * belongs in `state`. CO_ macros cannot be used inside a `switch` statement
+ * of the task function.
+ * 
+ * Suspending sets the task's `events` and `delay_ms`, the scheduler then 
+ * requeues the task as usual. A coroutine task is discarded when it reaches
+ * CO_END. Periodic coroutine tasks may only yield or sleep. A periodic task
+ * that yields resumes at its next period, and sleeping extends the current 
+ * period.
+ * 
+ * eg.
+ *   use RTOS;
+ * 
+ *   bool my_task_fn(Task_t * self) {
+ *       CO_BEGIN(self);
+ *       for (;;) {
+ *           start_conversion();
+ *           CO_SLEEP_MS(self, 2);
+ *           read_conversion();
+ *           CO_AWAIT_EVENT(self, BUTTON_PRESSED);
+ *           ...
+ *       }
+ *       CO_END(self);
+ *   }
+ */
+
+#ifdef RTOS_COROUTINE
+
+// Starts the body of a coroutine task function
+#define CO_BEGIN(task) switch ((task)->impl.resume) { case 0:
+
+// Saves the resume point and returns to the scheduler
+#define CO_SUSPEND(task)                   \
+    do {                                   \
+        (task)->impl.resume = __LINE__;    \
+        return true;                       \
+        case __LINE__:;                    \
+    } while (0)
+
+// Resumes after every other released task had a chance to run, or at the 
+// next period if the task is periodic
+#define CO_YIELD(task)                     \
+    do {                                   \
+        (task)->events   = 0;              \
+        (task)->delay_ms = 0;              \
+        CO_SUSPEND(task);                  \
+    } while (0)
+
+// Resumes once one of the events in `e` is dispatched
+#define CO_AWAIT_EVENT(task, e)            \
+    do {                                   \
+        (task)->events   = (e);            \
+        (task)->delay_ms = 0;              \
+        CO_SUSPEND(task);                  \
+    } while (0)
+
+// Resumes after `ms` milliseconds
+#define CO_SLEEP_MS(task, ms)              \
+    do {                                   \
+        (task)->events   = 0;              \
+        (task)->delay_ms = (ms);           \
+        CO_SUSPEND(task);                  \
+    } while (0)
+
+// Ends the body of a coroutine task function, the task is discarded
+#define CO_END(task) } (task)->impl.resume = 0; return false
+
+#endif
+
+#endif /* RTOS_COROUTINE_H */
@@ -33,10 +33,14 @@ namespace RTOS {
         Event_t init(const char * handle);
 
         /**
-         * Dispatches an event. Any task waiting for this event will be 
-         * scheduled in the next idle period. if RTOS_CHECK_EVENT is defined
-         * and the provided event was never created using Event::init a trace
-         * error will be produced.
+         * Dispatches an event. Every task waiting for this event will be 
+         * scheduled in the next idle period. Pending events are handled in 
+         * the order they were dispatched. An event no task is waiting for is
+         * kept for the first task that waits for it. Takes time proportional
+         * to the number of event tasks, but only holds off interrupts while 
+         * one task at a time is checked. May be called from an interrupt.
+         * If RTOS_CHECK_EVENT is defined and the provided event was never 
+         * created using Event::init a trace error will be produced.
          * 
          * @param Event_t e the event to schedule
          */
@@ -44,6 +48,112 @@ namespace RTOS {
 
     }
 
+    /**
+     * A unit of work deferred from an interrupt to a task.
+     */
+    typedef struct Work_t Work_t;
+    struct Work_t {
+        Event_t event; // The event the work belongs to
+        u16 payload;   // A value for the task, eg. an ADC sample
+        u32 time;      // Time::now_us32() when the work was pushed
+    };
+
+    /**
+     * A fixed size single producer, single consumer ring of work items. The 
+     * producer, usually an interrupt, pushes work and the consumer task pops
+     * it in the same order. Neither side disables interrupts to touch the
+     * ring, each only writes its own single byte index, and the producer 
+     * also sets a flag that the main loop clears when it wakes the consumer.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Ring_t * samples = Event::Ring::init<32>("samples", SAMPLE_READY);
+     * 
+     *   ISR(ADC_vect) {
+     *       Event::Ring::push(samples, SAMPLE_READY, ADC);
+     *   }
+     * 
+     *   bool my_task_fn(Task_t * self) {
+     *       Work_t work;
+     *       while (Event::Ring::pop(samples, &work)) {
+     *           ...
+     *       }
+     *       return true;
+     *   }
+     */
+    typedef struct Ring_t Ring_t;
+    struct Ring_t {
+        Event_t event;  // The event dispatched when work is pushed
+        u8 capacity;    // The number of work items the ring holds
+        u16 dropped;    // The number of work items pushed while the ring was full
+        // "hidden" fields
+        struct {
+            volatile u8 head;     // Free running index of the next item to pop
+            volatile u8 tail;     // Free running index of the next item to push
+            volatile bool pushed; // Set by push until the main loop dispatches
+            Work_t * data;        // The ring buffer
+            Ring_t * next;        // The next ring collected by the main loop
+        } impl;
+    };
+
+    namespace Event {
+    namespace Ring {
+
+        /**
+         * Allocates a new ring from the virtual heap that holds `capacity`
+         * work items. `capacity` must be a power of two no greater than 128.
+         * 
+         * @param   const char * handle   the debugging handle
+         * @param   Event_t      event    the event that wakes the consumer
+         * @param   u8           capacity the number of work items
+         * @returns Ring_t *              a pointer to the ring
+         */
+        Ring_t * init(const char * handle, Event_t event, u8 capacity);
+
+        /**
+         * Allocates a new ring like `init`, checking at compile time that 
+         * `Capacity` is a power of two no greater than 128.
+         * 
+         * @param   const char * handle the debugging handle
+         * @param   Event_t      event  the event that wakes the consumer
+         * @returns Ring_t *            a pointer to the ring
+         */
+        template <u8 Capacity>
+        Ring_t * init(const char * handle, Event_t event) {
+            static_assert(Capacity > 0 && Capacity <= 128 && (Capacity & (Capacity - 1)) == 0,
+                "Ring capacity must be a power of two no greater than 128");
+            return init(handle, event, Capacity);
+        }
+
+        /**
+         * Pushes a work item stamped with the current time. Only one producer
+         * may push to a ring. A push only stores the item and flags the ring,
+         * the main loop dispatches the ring's event once for every push since
+         * it last looked, so the consumer is queued once however much work
+         * piles up. If the ring is full the work is dropped and counted in 
+         * `dropped`.
+         * 
+         * @param   Ring_t * ring    the ring to push to
+         * @param   Event_t  event   the event the work belongs to
+         * @param   u16      payload a value for the consumer
+         * @returns bool             false if the work was dropped
+         */
+        bool push(Ring_t * ring, Event_t event, u16 payload);
+
+        /**
+         * Pops the oldest work item into `work`. Only one consumer may pop 
+         * from a ring. A consumer that stops before the ring is empty is run
+         * again after the next push.
+         * 
+         * @param   Ring_t * ring the ring to pop from
+         * @param   Work_t * work where to copy the work item
+         * @returns bool          false if the ring was empty
+         */
+        bool pop(Ring_t * ring, Work_t * work);
+
+    }}
+
 }
 
 #endif /* RTOS_EVENT_H */
\ No newline at end of file
@@ -25,6 +25,44 @@ namespace Memory {
      */
     void * static_alloc(const char * handle, u16 bytes);
 
+    #ifdef RTOS_STACK_PAINT
+    /**
+     * Returns the fewest bytes that have been left between the top of the 
+     * heap and the stack so far. The memory is scanned a little at a time 
+     * while idle, so a new low is only seen after the next full pass. Every 
+     * new low produces a stack trace. A buffer the stack skips over without
+     * writing is not seen.
+     * 
+     * @returns u16 the lowest free stack memory found in bytes
+     */
+    u16 stack_free();
+    #endif
+
+    #ifdef RTOS_SCRATCH
+    /**
+     * Allocates `bytes` of temporary memory for the task that is running. 
+     * Scratch memory is taken from one shared region and is released when the
+     * task function returns, so it must not be kept between runs, and a 
+     * coroutine task must not keep it across a yield. Returns nullptr, and
+     * produces a trace error if RTOS_CHECK_ALLOC is defined, if the region is
+     * out of memory. The most scratch memory a task has used in one run is
+     * reported when it stops.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   bool my_task_fn(Task_t * self) {
+     *       char * line = (char *) Memory::scratch(64);
+     *       ...
+     *       return true; // line is released here
+     *   }
+     * 
+     * @param   u16    bytes the number of bytes to allocate
+     * @returns void *       a pointer to the allocated bytes
+     */
+    void * scratch(u16 bytes);
+    #endif
+
     /**
      * A pool allocator provides fast dynamic memory allocation for fixed sized
      * chunks. A pool allocator is statically allocated and cannot be freed.
@@ -51,15 +89,37 @@ namespace Memory {
      *   my_linked_list = Pool::cons(Pool::alloc(my_pool), Pool::alloc(my_pool));
      *   *my_linked_list = 1;            // Set the first item to 1
      *   *Pool::cdr(my_linked_list) = 2; // Set the second itme to 2
+     * 
+     * Each chunk of a list pool carries a 2 byte pool node. A bitmap pool 
+     * instead tracks its free chunks with one bit each, which saves nearly 2
+     * bytes per chunk, but its chunks cannot be used with cons and cdr.
+     * 
+     * A growing pool is a list pool that takes each chunk from the virtual
+     * heap only when it is first allocated, so memory is only spent on as 
+     * many chunks as are ever in use at once.
+     * 
+     * eg.
+     *   use RTOS::Memory;
+     * 
+     *   Pool_t * my_pool = Pool::init("int pool", sizeof(int), 10, Pool_Bitmap);
      */
+    enum Pool_Kind_t {
+        Pool_List,   // Free chunks are linked through their pool nodes
+        Pool_Bitmap, // Free chunks are tracked in a bitmap, no pool nodes
+        Pool_Grow,   // A list pool that takes its chunks as they are needed
+    };
+
     typedef struct Pool_t Pool_t;
     struct Pool_t {
         u8 chunk;        // The number of bytes in each chunk
         u8 chunks;       // The number of chunks
         // "hidden" fields
         struct {
+            u8 kind;     // The Pool_Kind_t of this pool
             u8 * data;   // The memory buffer
-            void * head; // The current free head
+            void * head; // The current free head, or the bitmap of free chunks
+            u8 grown;    // The chunks a growing pool has taken so far
+            const char * handle; // The debugging handle a growing pool allocates with
         } impl;
     };
 
@@ -67,14 +127,16 @@ namespace Memory {
         
         /**
          * Allocates a new pool with `chunks` number of chunks, each of size
-         * `chunk`. Returns a pointer to the pool.
+         * `chunk`. Returns a pointer to the pool. A growing pool allocates its
+         * chunks later, as they are first needed.
          * 
          * @param  const char * handle the debugging handle
          * @param  u8           chunk  the size of each chunk
          * @param  u8           chunks the number of chunks
+         * @param  Pool_Kind_t  kind   how free chunks are tracked
          * @retuns Pool_t *            a pointer to the pool.
          */
-        Pool_t * init(const char * handle, u8 chunk, u8 chunks);
+        Pool_t * init(const char * handle, u8 chunk, u8 chunks, Pool_Kind_t kind = Pool_List);
 
         /**
          * Allocates a chunk and returns a pointer to it. If the pool is out of 
@@ -98,7 +160,7 @@ namespace Memory {
 
         /**
          * If this chunk is part of a cons cell, retrieves its cdr chunk, 
-         * otherwise returns NULL.
+         * otherwise returns NULL. Only valid for chunks of a list pool.
          * 
          * @param   void * chunk the chunk to get the cdr of
          * @returns void *       the cdr chunk
@@ -108,7 +170,7 @@ namespace Memory {
         /**
          * Constructs a cons cell from two chunks, with `chunk_car` pointing
          * its cdr to `chunk_cdr`. Returns `chunk_car``, which is used to 
-         * represent the cons cell.
+         * represent the cons cell. Only valid for chunks of a list pool.
          * 
          * @param   void * chunk_car the car chunk
          * @param   void * chunk_cdr the cdr chunk
@@ -116,6 +178,260 @@ namespace Memory {
          */
         void * cons(void * chunk_car, void * chunk_cdr);
 
+        /**
+         * Produces the allocation trace of a static pool the first time it
+         * is allocated from. Used by Static_Pool_t.
+         * 
+         * @param const char * handle the debugging handle
+         * @param u16          bytes  the size of the pool
+         */
+        void define(const char * handle, u16 bytes);
+
+        /**
+         * Produces the error trace of a static pool that is out of chunks.
+         * Used by Static_Pool_t.
+         */
+        void overflow();
+
+        /**
+         * Produces the error trace of a null chunk passed to a static pool.
+         * Used by Static_Pool_t.
+         */
+        void null_chunk();
+
+    }
+
+    /**
+     * A typed pool of `N` chunks of `T` laid out at compile time. The chunks
+     * live in the pool object itself, and the debugging handle `Handle` is a
+     * template argument so that every field starts out zero. A pool defined 
+     * at namespace scope is then zero initialized with the rest of .bss, 
+     * takes no flash for its chunks, needs no init loop and can be used from
+     * other static constructors. Chunks are handed out in order the first 
+     * time and reused through a free list once returned, and freed chunks 
+     * store the list in place so there is no per chunk overhead beyond each 
+     * chunk holding at least a pointer. Chunks cannot be used with cons and 
+     * cdr. The allocation trace is produced on the first allocation, since a
+     * static pool exists before RTOS::init.
+     * 
+     * eg.
+     *   use RTOS::Memory;
+     * 
+     *   const char readings[] = "readings";
+     *   Static_Pool_t<Reading_t, 300, readings> my_readings;
+     * 
+     *   Reading_t * a = my_readings.alloc();
+     *   my_readings.dealloc(a);
+     */
+    template <typename T, u16 N, const char * Handle>
+    class Static_Pool_t {
+        static_assert(N > 0, "RTOS: a static pool needs a chunk");
+        static_assert((u32) N * sizeof(T) <= 0xFFFF, "RTOS: a static pool can hold at most 65535 bytes");
+
+        union Chunk_t {
+            Chunk_t * next;                // The next free chunk, while free
+            alignas(T) u8 data[sizeof(T)]; // The chunk, while allocated
+
+            constexpr Chunk_t() : next(nullptr) {}
+        };
+
+        Chunk_t * head;     // The most recently freed chunk
+        u16 used;           // The chunks handed out at least once
+        Chunk_t chunks[N];  // The chunk buffer
+
+    public:
+
+        constexpr Static_Pool_t() : head(nullptr), used(0) {}
+
+        /**
+         * Allocates a chunk and returns a pointer to it, or nullptr if the 
+         * pool is out of chunks, in which case an error trace is produced if
+         * RTOS_CHECK_POOL is enabled.
+         * 
+         * @returns T * a chunk
+         */
+        T * alloc() {
+            Chunk_t * chunk = head;
+            if (chunk != nullptr) {
+                head = chunk->next;
+            } else if (used < N) {
+                if (used == 0) {
+                    Pool::define(Handle, sizeof(chunks));
+                }
+                chunk = &chunks[used++];
+            } else {
+                #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_POOL)
+                Pool::overflow();
+                #endif
+                return nullptr;
+            }
+            return (T *) chunk->data;
+        }
+
+        /**
+         * Deallocates a chunk (making it available to be allocated again). No
+         * references to this chunk should be maintained after deallocation.
+         * 
+         * @param T * chunk the chunk to deallocate
+         */
+        void dealloc(T * chunk) {
+            if (chunk == nullptr) {
+                #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_POOL)
+                Pool::null_chunk();
+                #endif
+                return;
+            }
+            Chunk_t * free = (Chunk_t *) chunk;
+            free->next = head;
+            head = free;
+        }
+    };
+
+    #ifdef RTOS_HEAP
+    /**
+     * A general purpose heap for variable sized buffers, carved from the 
+     * virtual heap when RTOS_HEAP is defined. Blocks are kept in a two level
+     * segregated fit (TLSF): free blocks are binned by the power of two of 
+     * their size and then by a quarter of that range, with a bitmap of the 
+     * bins in use. Allocating finds a bin with two find-first-set operations 
+     * and freeing merges a block with its physical neighbours, neither loops 
+     * over blocks, so both take a bounded time whatever the state of the 
+     * heap and can be used inside periodic tasks.
+     * 
+     * Each block carries a 4 byte header. Requests are rounded up to the next
+     * bin boundary, wasting at most a quarter of a block.
+     * 
+     * eg.
+     *   use RTOS::Memory;
+     * 
+     *   Packet_t * packet = (Packet_t *) Heap::alloc(sizeof(Packet_t) + length);
+     *   if (packet != nullptr) {
+     *       ...
+     *       Heap::free(packet);
+     *   }
+     */
+    namespace Heap {
+
+        /**
+         * Allocates at least `bytes` from the heap. Produces a heap trace. If
+         * the heap has no block large enough returns nullptr, and produces a
+         * trace error if RTOS_CHECK_ALLOC is defined.
+         * 
+         * @param   u16    bytes the number of bytes to allocate
+         * @returns void *       the block, or nullptr
+         */
+        void * alloc(u16 bytes);
+
+        /**
+         * Returns a block to the heap, merging it with any free neighbours.
+         * Produces a heap trace. Freeing nullptr does nothing, like free().
+         * 
+         * @param void * block the block returned by alloc
+         */
+        void free(void * block);
+
+        /**
+         * Returns the number of free bytes in the heap.
+         * 
+         * @returns u16 the free bytes
+         */
+        u16 available();
+
+        /**
+         * Returns how fragmented the free bytes are in per mille, 0 when they
+         * are one block and close to 1000 when they are many small ones. 
+         * Measured against the first block of the largest bin, so it may 
+         * overstate fragmentation by up to a quarter of the largest block.
+         * 
+         * @returns u16 the fragmentation in per mille
+         */
+        u16 fragmentation();
+
+    }
+    #endif
+
+    /**
+     * A first in first out queue of pool chunks used to pass messages between
+     * tasks. Sending a chunk passes its ownership to the receiver, chunks are
+     * linked through their pool nodes so nothing is copied. A chunk must not
+     * be used by the sender after it is sent, and must not be in another 
+     * list while it is queued.
+     * 
+     * Every send dispatches the queue's event. A receiver that listens for it
+     * is queued once however many messages are waiting, and is run again by
+     * the next send if it leaves messages in the queue. Sending to a full 
+     * queue fails and produces a backpressure trace.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Pool_t * my_pool = Memory::Pool::init("readings", sizeof(Reading_t), 8);
+     *   Queue_t * my_queue = Memory::Queue::init("readings", READING_SENT, 4);
+     * 
+     *   bool producer_fn(Task_t * self) {
+     *       Reading_t * reading = (Reading_t *) Memory::Pool::alloc(my_pool);
+     *       ...
+     *       if (!Memory::Queue::send(my_queue, reading)) {
+     *           Memory::Pool::dealloc(my_pool, reading);
+     *       }
+     *       return true;
+     *   }
+     * 
+     *   bool consumer_fn(Task_t * self) {
+     *       Reading_t * reading;
+     *       while ((reading = (Reading_t *) Memory::Queue::receive(my_queue))) {
+     *           ...
+     *           Memory::Pool::dealloc(my_pool, reading);
+     *       }
+     *       return true;
+     *   }
+     */
+    typedef struct Queue_t Queue_t;
+    struct Queue_t {
+        Event_t event; // The event dispatched when a message is sent
+        u8 capacity;   // The number of messages the queue holds
+        // "hidden" fields
+        struct {
+            u8 id;        // Used to identify the queue during a trace
+            u8 size;      // The number of queued messages
+            void * head;  // The oldest message
+            void * tail;  // The newest message
+        } impl;
+    };
+
+    namespace Queue {
+
+        /**
+         * Allocates a new queue from the virtual heap. Produces a trace that
+         * defines the queue.
+         * 
+         * @param   const char * handle   the debugging handle
+         * @param   Event_t      event    the event that wakes the receiver
+         * @param   u8           capacity the number of messages the queue holds
+         * @returns Queue_t *             a pointer to the queue
+         */
+        Queue_t * init(const char * handle, Event_t event, u8 capacity);
+
+        /**
+         * Sends a pool chunk to the back of the queue. If the queue is full
+         * nothing is sent, a backpressure trace is produced and the chunk 
+         * stays with the sender.
+         * 
+         * @param   Queue_t * queue the queue to send to
+         * @param   void *    chunk the pool chunk to send
+         * @returns bool            false if the queue was full
+         */
+        bool send(Queue_t * queue, void * chunk);
+
+        /**
+         * Receives the chunk at the front of the queue, the caller now owns 
+         * it.
+         * 
+         * @param   Queue_t * queue the queue to receive from
+         * @returns void *          the chunk, or nullptr if the queue is empty
+         */
+        void * receive(Queue_t * queue);
+
     }
 
 }}
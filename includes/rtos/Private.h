@@ -9,11 +9,45 @@
 
 namespace RTOS {
 
-    namespace Registers {
+    /**
+     * A fixed capacity binary min-heap of tasks ordered by the next time each
+     * task is expected to run. Tasks scheduled for the same time are ordered
+     * first in first out. The heap buffer holds RTOS_MAX_TASKS entries and is
+     * allocated from the virtual heap by RTOS::init.
+     */
+    typedef struct Task_Heap_t Task_Heap_t;
+    struct Task_Heap_t {
+        u8 size;          // The number of tasks in the heap
+        bool by_deadline; // Order by impl.deadline instead (RTOS_EDF only)
+        u16 order;        // Insertion counter used to break ties
+        Task_t ** data;   // The heap buffer
+    };
+
+    /**
+     * The event tasks subscribed to at least one event, in no particular 
+     * order. Each task keeps its index in `impl.slot`, so it is removed in 
+     * constant time. The buffer holds RTOS_MAX_TASKS entries and is 
+     * allocated from the virtual heap by RTOS::init.
+     */
+    typedef struct Task_List_t Task_List_t;
+    struct Task_List_t {
+        u8 size;        // The number of tasks in the list
+        Task_t ** data; // The list buffer
+    };
 
-        // A value that will be set with the bitwise ORed values of all active
-        // events
-        extern volatile Event_t events;
+    /**
+     * A first in first out queue of event tasks with pending events, linked
+     * through their pool chunks. A task is queued when its first pending 
+     * event is dispatched, so it appears in the queue at most once. Shared 
+     * with interrupt context, so it must only be accessed in an atomic block.
+     */
+    typedef struct Event_Queue_t Event_Queue_t;
+    struct Event_Queue_t {
+        Task_t * volatile head; // The task that has waited the longest
+        Task_t * tail;          // The task that was queued last
+    };
+
+    namespace Registers {
 
         // The last trace that occured.
         extern volatile Trace_t trace;
@@ -24,42 +58,274 @@ namespace RTOS {
         // Current task being run
         extern Task_t * current_task;
 
-        // Head of a task list used for periodic tasks
-        extern Task_t * periodic_tasks;
+        // Heap of tasks used for periodic tasks
+        extern Task_Heap_t periodic_tasks;
 
         // Head of a task list used for delayed tasks
         extern Task_t * delayed_tasks;
 
-        // Head of a task list used for event tasks
-        extern Task_t * event_tasks;
+        #ifdef RTOS_EDF
+        // Heap of released tasks ordered by absolute deadline
+        extern Task_Heap_t ready_tasks;
+        #endif
+
+        // The dispatcher of the attached static task set, or nullptr
+        extern static_dispatch_t static_tasks;
+
+        // Every event task, dispatched events are fanned out to each of them
+        extern Task_List_t event_tasks;
+
+        // Event tasks waiting to handle their pending events
+        extern Event_Queue_t event_queue;
+
+    }
+
+    namespace Event {
+
+        /**
+         * Returns the event task that has waited the longest to handle its
+         * pending events, or nullptr if no event task is waiting. The task 
+         * stays queued.
+         * 
+         * @returns Task_t * the next event task
+         */
+        Task_t * next();
+
+        /**
+         * Removes the task returned by `next` from the event queue. Its 
+         * pending events are kept until the task runs.
+         */
+        void pop();
+
+        /**
+         * Returns true if an event task is waiting to run. Used to end idle
+         * time early.
+         * 
+         * @returns bool true if the event queue is not empty
+         */
+        bool waiting();
+
+        /**
+         * Delivers to `task` the events it listens for that were dispatched
+         * while no task listened for them. Only the first task to listen for
+         * such an event receives it. MUST BE CALLED IN AN ATOMIC BLOCK!
+         * 
+         * @param Task_t * task the newly subscribed task
+         */
+        void claim(Task_t * task);
+
+        namespace Ring {
+
+            /**
+             * Dispatches the event of every ring pushed to since the last 
+             * call. Called from the main loop, so a push from an interrupt 
+             * never dispatches itself.
+             */
+            void collect();
+
+            /**
+             * Returns true if a ring was pushed to since the last `collect`. 
+             * Used to end idle time early.
+             * 
+             * @returns bool true if a ring has work to dispatch
+             */
+            bool pushed();
+
+        }
+
+    }
+
+    #ifdef RTOS_BUDGET
+    namespace Time {
+
+        /**
+         * Arms the timer1 compare B interrupt to produce an overrun error for
+         * the current task once `budget_us` has passed.
+         * 
+         * @param u16 budget_us the execution budget
+         */
+        void arm_budget(u16 budget_us);
+
+        /**
+         * Disarms the budget interrupt once the current task returns.
+         */
+        void disarm_budget();
+
+    }
+    #endif
+
+    #ifdef RTOS_STACK_PAINT
+    namespace Memory {
+    namespace Stack {
+
+        /**
+         * Paints the memory between the top of the heap and the stack 
+         * pointer.
+         */
+        void paint();
+
+        /**
+         * Checks the next few painted bytes for a new stack low. Called from
+         * Time::idle.
+         */
+        void scan();
+
+    }}
+    #endif
+
+    #ifdef RTOS_SCRATCH
+    namespace Memory {
+    namespace Scratch {
+
+        /**
+         * Allocates the scratch region from the virtual heap.
+         */
+        void init();
+
+        /**
+         * Returns the number of scratch bytes in use, to be passed to 
+         * `rewind` once the running task returns.
+         * 
+         * @returns u16 the scratch bytes in use
+         */
+        u16 mark();
+
+        /**
+         * Releases the scratch memory allocated since `mark`.
+         * 
+         * @param u16 mark the scratch bytes in use before the task ran
+         */
+        void rewind(u16 mark);
+
+    }}
+    #endif
+
+    #ifdef RTOS_HEAP
+    namespace Memory {
+    namespace Heap {
+
+        /**
+         * Allocates the heap from the virtual heap.
+         */
+        void init();
+
+    }}
+    #endif
 
-        // Tail of a task list used for event tasks
-        extern Task_t * event_tasks_tail;
+    #ifdef RTOS_SERVER
+    namespace Server {
+
+        /**
+         * Returns how long event tasks must wait for the server budget to be
+         * replenished at `time`, or 0 if budget is left. The first time the 
+         * budget is found spent in a period a Mark_Exhausted trace is sent.
+         * 
+         * @param   Time_t       time the current time
+         * @returns Time_Delta_t      the time until budget is available
+         */
+        Time_Delta_t wait(Time_t time);
+
+        /**
+         * Draws `elapsed_us` from the server budget after an event task ran.
+         * 
+         * @param Time_Delta_t elapsed_us the runtime of the event task
+         */
+        void charge(Time_Delta_t elapsed_us);
+
+        /**
+         * Returns true if the budget ran out in the current period. Used so 
+         * that waiting event tasks do not end idle time early.
+         * 
+         * @returns bool true if the server is exhausted
+         */
+        bool depleted();
 
     }
+    #endif
+
+    #ifdef RTOS_PREEMPT
+    namespace Preempt {
+
+        /**
+         * Allocates the stack pool used by preemptive tasks.
+         */
+        void init();
+
+        /**
+         * Gives `task` a context and a stack so it can be released by 
+         * `schedule`. Returns false if RTOS_PREEMPT_TASKS is exceeded.
+         * 
+         * @param   Task_t * task the preemptive task
+         * @returns bool          true if the task was added
+         */
+        bool add(Task_t * task);
+
+        /**
+         * Called by Task::run after a preemptive task returns. Computes the
+         * task's next release if it will be scheduled again. The context 
+         * state is left to the caller, which must change it with interrupts
+         * disabled.
+         * 
+         * @param   Task_t * task   the preemptive task
+         * @param   bool     result the value returned by the task function
+         * @returns bool            true if the task will run again
+         */
+        bool requeue(Task_t * task, bool result);
+
+        /**
+         * Frees the stacks and tasks of finished preemptive tasks. Must be
+         * called from the main loop.
+         */
+        void reclaim();
+
+        #ifdef RTOS_ADMISSION
+        /**
+         * Copies the periodic preemptive tasks into `set`, which must have 
+         * room for RTOS_PREEMPT_TASKS tasks. Used by the admission test.
+         * 
+         * @param   Task_t ** set where to copy the tasks
+         * @returns u8             the number of tasks copied
+         */
+        u8 periodic(Task_t ** set);
+        #endif
+
+        /**
+         * Releases preemptive tasks that are due or whose events are pending
+         * and switches to the highest priority context if it is not the 
+         * current one. MUST BE CALLED WITH INTERRUPTS DISABLED!
+         */
+        void schedule();
+
+    }
+    #endif
 
     namespace Task {
 
         // Special case, task is an event task when it enters, but a periodic task when it leaves
         // Need to check if task has events on enter
-        // If it does, need to manually remove it from event_tasks after
+        // If it does, need to manually unsubscribe it after
         // Not a big deal. Need to copy events anyways in order to clear the events register
 
         /**
          * Runs a task. Produces a trace for the start and stop of the task. If
          * the task is an event task, all events it responded to will be 
          * cleared.
+         * 
+         * @param   Task_t * task the task to run
+         * @returns bool          true if the task will run again, false if it
+         *                        was freed or is a finished preemptive task
          */
-        void run(Task_t * task);
+        bool run(Task_t * task);
 
         /**
          * Returns true if the task is expected to fit in the given time 
          * window.
          * 
-         * @param   Task_t * task the task
-         * @returns bool          true if the task fits
+         * @param   Task_t *     task the task
+         * @param   Time_Delta_t time the time window
+         * @returns bool              true if the task fits
          */
-        bool fits(Task_t * task, i64 time);
+        bool fits(Task_t * task, Time_Delta_t time);
 
         /**
          * Returns the next task in a task list. If the provided task list has
@@ -71,19 +337,28 @@ namespace RTOS {
         Task_t * cdr(Task_t * tasks);
 
         /**
-         * Inserts `task` as the tail of `tasks_tail`. 
+         * Adds `task` to the event tasks. Dispatched events are matched 
+         * against its `events` field as it is at the time of dispatch. If 
+         * RTOS_CHECK_TASK is defined, subscribing more than RTOS_MAX_TASKS 
+         * tasks produces an error trace and the task is not added.
          * 
-         * @param   Task_t * tasks the tail of a task list
-         * @param   Task_t * task  the task to insert
-         * @returns Task_t *       the new tail of the task list
+         * @param Task_t * task the task to subscribe
          */
-        Task_t * insert_tail(Task_t * tasks_tail, Task_t * task);
+        void subscribe(Task_t * task);
+
+        /**
+         * Removes `task` from the event tasks, dropping any events that are
+         * still pending for it and removing it from the event queue.
+         * 
+         * @param Task_t * task the task to unsubscribe
+         */
+        void unsubscribe(Task_t * task);
 
         /**
          * Inserts `task` into `tasks` at an ordered position. Order is based 
          * which task should be scheduled next. If two tasks are scheduled for
          * the same time the task that wa salready in `tasks` should appear
-         * first.
+         * first. Caches the next release time of `task` before inserting.
          * 
          * @param Task_t * tasks the head of a task list
          * @param Task_t * task  the task to insert
@@ -92,24 +367,91 @@ namespace RTOS {
         Task_t * insert_ordered(Task_t * tasks, Task_t * task);
 
         /**
-         * Calculates the next time the given task is expected to be run.
+         * Returns the task at the top of `heap` without removing it, or 
+         * nullptr if the heap is empty.
          * 
-         * @param   Task_t * task the task
-         * @returns i64           the next expected time
+         * @param   Task_Heap_t * heap the heap
+         * @returns Task_t *           the next task in the heap
          */
-        i64 time_next(Task_t * task);
+        Task_t * heap_peek(Task_Heap_t * heap);
 
         /**
-         * Calculates the time remaining for a given task and a given point in
-         * time. Time remaining is calulated by:
+         * Removes and returns the task at the top of `heap`. The heap must not
+         * be empty.
          * 
-         *   (last_time + period + delay) - time
+         * @param   Task_Heap_t * heap the heap
+         * @returns Task_t *           the removed task
+         */
+        Task_t * heap_pop(Task_Heap_t * heap);
+
+        /**
+         * Inserts `task` into `heap`. If two tasks are scheduled for the same
+         * time the task that was already in `heap` will be popped first. 
+         * Caches the next release time of `task` before inserting, unless 
+         * the heap is ordered by deadline.
+         * 
+         * @param Task_Heap_t * heap the heap
+         * @param Task_t *      task the task to insert
+         */
+        void heap_push(Task_Heap_t * heap, Task_t * task);
+
+        #ifdef RTOS_ADMISSION
+        /**
+         * Tests if the periodic tasks already dispatched together with `task`
+         * are schedulable, first by the Liu-Layland utilization bound and 
+         * then by an exact rate monotonic response time analysis. Both count
+         * the blocking of a task by the longest lower priority task, as run-
+         * to-completion tasks cannot be preempted. Preemptive tasks are 
+         * analysed ahead of every run-to-completion task, by priority. 
+         * Produces an admission trace, and an overload error if the test 
+         * fails.
+         * 
+         * @param   Task_t * task the periodic task being dispatched
+         * @returns bool          true if the task can be dispatched
+         */
+        bool admit(Task_t * task);
+        #endif
+
+        #ifdef RTOS_EDF
+        /**
+         * Returns the relative deadline of a task, `deadline_ms`, or its 
+         * period if no deadline was set.
+         * 
+         * @param   Task_t *     task the task
+         * @returns Time_Delta_t      the relative deadline
+         */
+        Time_Delta_t deadline(Task_t * task);
+
+        /**
+         * Moves a released task into the ready heap. Timed tasks get their 
+         * absolute deadline from their release time, event tasks already got
+         * theirs when their event was dispatched.
+         * 
+         * @param Task_t * task the released task
+         */
+        void release(Task_t * task);
+        #endif
+
+        /**
+         * Calculates the next time the given task is expected to be run. This
+         * is the value cached in `impl.next_release` when a task is queued.
          * 
          * @param   Task_t * task the task
-         * @param   i64      time the time to measure from
-         * @returns i64           the remaining time
+         * @returns Time_t        the next expected time
+         */
+        Time_t time_next(Task_t * task);
+
+        /**
+         * Calculates the time remaining for a given queued task and a given 
+         * point in time. Time remaining is calulated by:
+         * 
+         *   next_release - time
+         * 
+         * @param   Task_t *     task the task
+         * @param   Time_t       time the time to measure from
+         * @returns Time_Delta_t      the remaining time
          */
-        i64 time_remaining(Task_t * task, i64 time_ms);
+        Time_Delta_t time_remaining(Task_t * task, Time_t time_ms);
 
     }
 
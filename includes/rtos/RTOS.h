@@ -6,9 +6,12 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <avr/pgmspace.h>
 #include <util/atomic.h>
 
 //
@@ -47,6 +50,8 @@ typedef signed long long i64;
 #include "Time.h"
 #include "Memory.h"
 #include "Task.h"
+#include "Coroutine.h"
+#include "Static.h"
 #include "Trace.h"
 
 namespace RTOS {
@@ -0,0 +1,221 @@
+#pragma once
+
+#ifndef RTOS_STATIC_H
+#define RTOS_STATIC_H
+
+namespace RTOS {
+
+    /**
+     * The type of a static task function. Static tasks have no Task_t, they
+     * always run again on their next release.
+     */
+    typedef void (*static_fn_t)();
+
+    /**
+     * The type of the dispatcher of a static task set, see Static_Tasks_t. 
+     * Runs the frame due at `now`, if there is one, and returns the time 
+     * until the next frame is due, or 0 if a frame was run.
+     */
+    typedef Time_Delta_t (*static_dispatch_t)(Time_t now);
+
+    /**
+     * A periodic task known at compile time. `Fn` is run every `Period_ms`,
+     * starting `Offset_ms` into the schedule. The offset must be less than 
+     * the period.
+     */
+    template <static_fn_t Fn, u16 Period_ms, u16 Offset_ms = 0>
+    struct Static_Task_t {
+        static_assert(Period_ms > 0, "RTOS: a static task needs a period");
+        static_assert(Offset_ms < Period_ms, "RTOS: a static task offset must be less than its period");
+
+        static constexpr u16 period = Period_ms;
+        static constexpr u16 offset = Offset_ms;
+
+        static inline void run() {
+            Fn();
+        }
+
+        // Returns true if the task is released at `time` into the schedule
+        static constexpr bool released(u32 time) {
+            return time % Period_ms == Offset_ms;
+        }
+    };
+
+    namespace Static {
+
+        constexpr u32 gcd(u32 a, u32 b) {
+            return b == 0 ? a : gcd(b, a % b);
+        }
+
+        constexpr u32 lcm(u32 a, u32 b) {
+            return a / gcd(a, b) * b;
+        }
+
+        // Folds a static task set into its schedule parameters
+        template <typename... Tasks>
+        struct Set;
+
+        template <>
+        struct Set<> {
+            static constexpr u32 hyperperiod() { return 1; }
+            static constexpr u32 frame() { return 0; }
+            static constexpr u32 mask(u32, u8) { return 0; }
+            static inline void run(u32) {}
+        };
+
+        template <typename Task, typename... Tasks>
+        struct Set<Task, Tasks...> {
+            // The time after which the whole schedule repeats
+            static constexpr u32 hyperperiod() {
+                return lcm(Task::period, Set<Tasks...>::hyperperiod());
+            }
+            // The longest frame every release falls on the start of
+            static constexpr u32 frame() {
+                return gcd(gcd(Task::period, Task::offset), Set<Tasks...>::frame());
+            }
+            // The tasks released at `time`, the first task is bit `bit`
+            static constexpr u32 mask(u32 time, u8 bit) {
+                return (Task::released(time) ? (u32) 1 << bit : 0) | Set<Tasks...>::mask(time, bit + 1);
+            }
+            // Runs the tasks in `mask` in declaration order
+            static inline void run(u32 mask) {
+                if (mask & 1) {
+                    Task::run();
+                }
+                if (mask >> 1) {
+                    Set<Tasks...>::run(mask >> 1);
+                }
+            }
+        };
+
+        // The smallest mask type for `N` tasks
+        template <bool Byte, bool Word>
+        struct Mask { typedef u32 type; };
+        template <bool Word>
+        struct Mask<true, Word> { typedef u8 type; };
+        template <>
+        struct Mask<false, true> { typedef u16 type; };
+
+        template <u16... Is>
+        struct Frames {};
+
+        template <u16 N, u16... Is>
+        struct Make_Frames : Make_Frames<N - 1, N - 1, Is...> {};
+
+        template <u16... Is>
+        struct Make_Frames<0, Is...> { typedef Frames<Is...> type; };
+
+        // The dispatch table of a static task set, one mask per frame, kept 
+        // in flash
+        template <typename S, typename M, typename F>
+        struct Table;
+
+        template <typename S, typename M, u16... Is>
+        struct Table<S, M, Frames<Is...>> {
+            static const M data[sizeof...(Is)];
+
+            static inline M read(u16 frame) {
+                return sizeof(M) == 1 ? pgm_read_byte(&data[frame])
+                     : sizeof(M) == 2 ? pgm_read_word(&data[frame])
+                     : pgm_read_dword(&data[frame]);
+            }
+        };
+
+        template <typename S, typename M, u16... Is>
+        const M Table<S, M, Frames<Is...>>::data[sizeof...(Is)] PROGMEM = {
+            (M) S::mask((u32) Is * S::frame(), 0)...
+        };
+
+        /**
+         * Makes `dispatch` the static task set run by RTOS::dispatch. Only
+         * one static task set can be attached.
+         * 
+         * @param static_dispatch_t dispatch the dispatcher of the set
+         */
+        void attach(static_dispatch_t dispatch);
+
+    }
+
+    /**
+     * A set of periodic tasks that is scheduled entirely at compile time. The
+     * hyperperiod of the set is split into frames of the greatest common 
+     * divisor of every period and offset, and a table in flash holds which 
+     * tasks are released in each frame. At run time each due frame costs a 
+     * table read and the calls, no task is allocated and no list or heap is
+     * touched.
+     * 
+     * Static tasks are run before any dynamic task, in the order they are 
+     * declared, and are not traced. Dynamic tasks keep working alongside 
+     * them. The set may hold up to 32 tasks, and its hyperperiod up to 512
+     * frames.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   void read_sensors();
+     *   void update_display();
+     * 
+     *   typedef Static_Tasks_t<
+     *       Static_Task_t<read_sensors, 10>,
+     *       Static_Task_t<update_display, 25, 5>
+     *   > My_Tasks;
+     * 
+     *   int main() {
+     *       RTOS::init();
+     *       My_Tasks::start();
+     *       ...
+     *       RTOS::dispatch();
+     *   }
+     */
+    template <typename... Tasks>
+    class Static_Tasks_t {
+        typedef Static::Set<Tasks...> Set;
+        typedef typename Static::Mask<sizeof...(Tasks) <= 8, sizeof...(Tasks) <= 16>::type Mask;
+
+        static constexpr u32 FRAME_MS    = Set::frame();
+        static constexpr u32 HYPERPERIOD = Set::hyperperiod();
+        static constexpr u32 FRAMES      = HYPERPERIOD / FRAME_MS;
+
+        static_assert(sizeof...(Tasks) > 0, "RTOS: a static task set needs a task");
+        static_assert(sizeof...(Tasks) <= 32, "RTOS: a static task set holds at most 32 tasks");
+        static_assert(FRAMES <= 512, "RTOS: the static task set has too many frames, make the periods share a larger divisor");
+
+        typedef Static::Table<Set, Mask, typename Static::Make_Frames<FRAMES>::type> Table;
+
+        static u16 frame;  // The next frame to run
+        static Time_t due; // When the next frame is due
+
+        static Time_Delta_t dispatch(Time_t now) {
+            Time_Delta_t remaining = (Time_Delta_t) (due - now);
+            if (remaining > 0) {
+                return remaining;
+            }
+            Set::run(Table::read(frame));
+            if (++frame == FRAMES) {
+                frame = 0;
+            }
+            due += FRAME_MS;
+            return 0;
+        }
+
+    public:
+
+        /**
+         * Starts the set, the first frame is due immediately.
+         */
+        static void start() {
+            frame = 0;
+            due = Time::now();
+            Static::attach(dispatch);
+        }
+    };
+
+    template <typename... Tasks>
+    u16 Static_Tasks_t<Tasks...>::frame = 0;
+
+    template <typename... Tasks>
+    Time_t Static_Tasks_t<Tasks...>::due = 0;
+
+}
+
+#endif /* RTOS_STATIC_H */
@@ -7,6 +7,12 @@ namespace RTOS {
 
     typedef struct Task_t Task_t;
 
+    // The number of runtime histogram buckets kept for each task
+    #define TASK_HISTOGRAM_BUCKETS 8
+
+    // The `impl.slot` of a task that is not subscribed to any events
+    #define TASK_UNSUBSCRIBED 0xFF
+
     /**
      * The type of a task function. Task functions return a bool that indicates
      * whether they should be scheduled again, true they will be, false they
@@ -21,6 +27,9 @@ namespace RTOS {
      *       ...
      *       return true; // Schedule me again please!
      *   }
+     * 
+     * If RTOS_COROUTINE is defined, task functions that need to wait part 
+     * way through can be written as coroutines instead, see Coroutine.h.
      */
     typedef bool (*task_fn_t)(Task_t * self);
 
@@ -63,9 +72,15 @@ namespace RTOS {
      *  3. EVENT DRIVEN
      *     A task can be made to run after a specified event occurs. These 
      *     tasks will be run during RTOS idle time. A task can be made to run
-     *     after multiple events, however multiple tasks cannot listen for the
-     *     same event. Event driven task should NOT have a period greater than 
-     *     0. 
+     *     after multiple events, and multiple tasks can listen for the same 
+     *     event. Each task keeps its own pending events, so every task 
+     *     listening for an event runs once after it is dispatched, in the 
+     *     order the events were dispatched. An event dispatched while no 
+     *     task listens for it is kept, and only the first task to listen for
+     *     it afterwards runs for it. Event driven task should NOT
+     *     have a period greater than 0. 
+     *     If RTOS_SERVER is defined event tasks share a budget of processor 
+     *     time, and wait for it to be replenished once it is spent.
      * 
      *  eg. 
      *    use RTOS;
@@ -79,18 +94,9 @@ namespace RTOS {
      *    my_task->events |= EVENT_2; // Run after EVENT_2 is dispatched
      *    Task::dispatch(my_task);
      *
-     *     The preffered method to trigger multiple tasks from a single event
-     *     is to use delayed tasks. This can be preferrable to a single task
-     *     doing all the work as it allows the tasks to be performed during
-     *     different idle times. Note that the tasks will be performed in a 
-     *     first in first out order.
-     * eg. 
-     *   bool multi_task_fn() {
-     *       Task::dispatch(Task::init("my_task_1", my_task_1_fn));
-     *       Task::dispatch(Task::init("my_task_2", my_task_2_fn));
-     *       Task::dispatch(Task::init("my_task_3", my_task_3_fn));
-     *       return true;
-     *   }
+     *    Task_t * my_logger = Task::init("my_logger", my_logger_fn);
+     *    my_logger->events = EVENT_1; // Also runs after EVENT_1
+     *    Task::dispatch(my_logger);
      * 
      *  4. IMMEDIATE
      *     A task will be scheduled immediately if it has a period of 0, delay
@@ -104,22 +110,136 @@ namespace RTOS {
      * 
      *   Task::dispatch(Task::init("my_task", my_task_fn));
      * 
+     *  5. EARLIEST DEADLINE FIRST
+     *     If RTOS_EDF is defined every released task, periodic, delayed or 
+     *     event driven, is run in order of its absolute deadline. A task's
+     *     absolute deadline is the time it was released (or the time its 
+     *     event was dispatched) plus `deadline_ms`. If `deadline_ms` is 0 the
+     *     period is used instead, and tasks with neither are run last. A task
+     *     that finishes after its deadline produces a deadline error trace.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Task_t * my_task = Task::init("my_task", my_task_fn);
+     *   my_task->events      = MY_EVENT;
+     *   my_task->deadline_ms = 5; // Must be handled within 5 ms
+     *   Task::dispatch(my_task);
+     * 
+     *  6. ADMISSION CONTROL
+     *     If RTOS_ADMISSION is defined every periodic task is tested against
+     *     the periodic tasks already dispatched before it is accepted. The 
+     *     worst case execution time of a task is `wcet_us`, or the maximum 
+     *     runtime measured so far if it is 0. Tasks are analysed in rate 
+     *     monotonic order (shorter periods first) with their deadline equal
+     *     to their period, or `deadline_ms` if that is shorter. As tasks run
+     *     to completion, each task can also be blocked by the longest lower
+     *     priority task. Preemptive tasks are analysed ahead of the others, 
+     *     by priority. A task that fails the test is not dispatched and 
+     *     produces an overload error. Delayed and event tasks are not part 
+     *     of the test.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Task_t * my_task = Task::init("my_task", my_task_fn);
+     *   my_task->period_ms = 10;
+     *   my_task->wcet_us   = 1500; // Never takes longer than 1.5 ms
+     *   Task::dispatch(my_task);
+     * 
+     *  7. EXECUTION BUDGET
+     *     If RTOS_BUDGET is defined a task with a `budget_us` greater than 0
+     *     is timed while it runs. If it is still running once its budget is
+     *     spent an overrun error is produced from an interrupt, with the time
+     *     the task has been running. Returning false from UDF::error halts 
+     *     the RTOS, returning true lets the task carry on. The overrun is 
+     *     detected within a millisecond of the budget running out, and 
+     *     counted in the task's `impl.overruns`.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Task_t * my_task = Task::init("my_task", my_task_fn);
+     *   my_task->period_ms = 10;
+     *   my_task->budget_us = 2000; // Something is wrong after 2 ms
+     *   Task::dispatch(my_task);
+     * 
+     *  8. PREEMPTIVE
+     *     If RTOS_PREEMPT is defined, a periodic, delayed or event driven task
+     *     with a `priority` greater than 0 is run on its own stack as soon as
+     *     it is released, preempting any run-to-completion task and any 
+     *     preemptive task of lower priority. Preemptive tasks must not create
+     *     or dispatch tasks or allocate memory, but may dispatch events.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   Task_t * my_task = Task::init("my_task", my_task_fn);
+     *   my_task->period_ms = 10;
+     *   my_task->priority  = 1;
+     *   Task::dispatch(my_task);
+     * 
      */
     struct Task_t {
-        task_fn_t fn;   // A pointer to the task funtion
-        void * state;   // A pointer to the task's associated state
-        Event_t events; // The events that cause this task to be scheduled
-        i16 period_ms;  // The schedule period of this task (in milliseconds)
-        i16 delay_ms;   // The delay before this task is scheduled
+        task_fn_t fn;    // A pointer to the task funtion
+        void * state;    // A pointer to the task's associated state
+        Event_t events;  // The events that cause this task to be scheduled
+        i16 period_ms;   // The schedule period of this task (in milliseconds)
+        i16 delay_ms;    // The delay before this task is scheduled
+        #ifdef RTOS_PREEMPT
+        u8 priority;     // The preemption priority, 0 runs to completion
+        #endif
+        #if defined(RTOS_EDF) || defined(RTOS_ADMISSION)
+        i16 deadline_ms; // The relative deadline, 0 if it is the period
+        #endif
+        #ifdef RTOS_ADMISSION
+        u16 wcet_us;     // The declared worst case execution time, 0 if unknown
+        #endif
+        #ifdef RTOS_BUDGET
+        u16 budget_us;   // The execution budget, 0 for none
+        #endif
         // "hidden" fields
         struct {
             bool first;
-            u8 instance; // Used to identify a task during a trace
-            i64 last;    // The last time this task was run
-            i16 maximum; // The maximum runtime of this task so far
+            u8 instance;         // Used to identify a task during a trace
+            u16 order;           // Insertion order used to break ties in a heap
+            #ifdef RTOS_COROUTINE
+            u16 resume;          // The resume point of a coroutine task, see Coroutine.h
+            #endif
+            Time_t last;         // The last time this task was run
+            Time_t next_release; // The next time this task is expected to run
+            Event_t pending;     // Events dispatched to this task it has not handled
+            u8 slot;             // The index of this task in the event tasks
+            #ifdef RTOS_EDF
+            Time_t deadline;     // The absolute deadline of the current release
+            bool ready;          // True while the task is in the ready heap
+            #endif
+            #ifdef RTOS_TIME_US
+            i32 maximum;         // The maximum runtime of this task so far (us)
+            #else
+            i16 maximum;         // The maximum runtime of this task so far (ms)
+            #endif
+            #ifdef RTOS_FIT_PERCENTILE
+            u8 histogram[TASK_HISTOGRAM_BUCKETS]; // Runtime counts by log2 bucket
+            #endif
+            #ifdef RTOS_SCRATCH
+            u16 scratch;         // The most scratch memory used in one run (bytes)
+            #endif
+            #ifdef RTOS_BUDGET
+            u8 overruns;         // The number of runs that overran the budget, up to 255
+            #endif
         } impl;
     };
 
+    /**
+     * The results of the admission test, see RTOS_ADMISSION in Conf.h.
+     */
+    enum Admission_t {
+        Admission_Rejected, // The task set is not schedulable
+        Admission_Bound,    // Accepted by the utilization bound
+        Admission_Exact,    // Accepted by the response time analysis
+    };
+
     namespace Task {
 
         /**
@@ -145,13 +265,31 @@ namespace RTOS {
         /**
          * Dipsatches the task to the scheduler. If RTOS_CHECK_TASK is defined
          * the fields of this task wil lbe verified such that if `period` or 
-         * `delay` is set than `events` will be 0, or vice versa. Will also 
-         * check that no other task is set to the same events.
+         * `delay` is set than `events` will be 0, or vice versa.
+         * 
+         * If RTOS_ADMISSION is defined and `task` is periodic, the task set
+         * is tested for schedulability first. If RTOS_TRACE is defined this 
+         * produces an admission trace with the result and the cost of the 
+         * test. If the test fails an overload error is produced and the task
+         * is not dispatched.
          * 
          * @param Task_t * task the tast to dispatcj
          */
         void dispatch(Task_t * task);
 
+        /**
+         * Produces a histogram trace with the runtime histogram of `task`. 
+         * Bucket 0 counts runs shorter than 1 ms (64 us if RTOS_TIME_US is 
+         * defined), each following bucket counts runs up to twice as long as
+         * the one before it, and the last bucket counts every longer run. 
+         * Counts are halved when one of them would overflow, so recent runs
+         * weigh more. Does nothing unless RTOS_FIT_PERCENTILE and RTOS_TRACE
+         * are defined.
+         * 
+         * @param Task_t * task the task to trace
+         */
+        void trace_histogram(Task_t * task);
+
     }
 
 }
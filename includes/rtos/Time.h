@@ -4,6 +4,40 @@
 #define RTOS_TIME_H
 
 namespace RTOS {
+
+    /**
+     * A type representing a point in time in milliseconds. If RTOS_TIME_32 is
+     * defined time is an unsigned 32 bit value that wraps around, otherwise it
+     * is a signed 64 bit value.
+     * 
+     * Times should only be compared through their difference, which is 
+     * wraparound safe so long as the two times are less than 2^31 ms apart.
+     * 
+     * eg.
+     *   use RTOS;
+     * 
+     *   if ((Time_Delta_t) (Time::now() - deadline) > 0) {
+     *       // deadline has passed
+     *   }
+     */
+    #ifdef RTOS_TIME_32
+        typedef u32 Time_t;
+        typedef i32 Time_Delta_t;
+    #else
+        typedef i64 Time_t;
+        typedef i64 Time_Delta_t;
+    #endif
+
+    /**
+     * The sleep modes the RTOS may use while idle. See RTOS_DEEP_SLEEP in
+     * Conf.h for when deeper modes are chosen.
+     */
+    enum Sleep_Mode_t {
+        Sleep_Idle,       // Timer1 keeps running, wakes on any interrupt
+        Sleep_Power_Save, // Timer2 keeps running from its external crystal
+        Sleep_Power_Down, // Only the watchdog keeps running
+    };
+
 namespace Time {
 
     /**
@@ -32,9 +66,46 @@ namespace Time {
     /**
      * Returns the current time in ms.
      * 
+     * @returns Time_t the current time
+     */
+    Time_t now();
+
+    /**
+     * Returns the current time in us. Built from the millisecond clock and the
+     * timer1 counter, with a resolution of 4 us. The result never runs ahead
+     * of `now`. If RTOS_TIME_32 is defined the value wraps around roughly 
+     * every 71 minutes, long before `now` does, so it should only be used to 
+     * measure intervals and not be compared with `now`.
+     * 
+     * @returns Time_t the current time
+     */
+    Time_t now_us();
+
+    /**
+     * Returns the low 32 bits of `now_us`, computed without 64 bit 
+     * arithmetic so it is cheap enough to call from an interrupt. Wraps 
+     * around roughly every 71 minutes.
+     * 
+     * @returns u32 the current time
+     */
+    u32 now_us32();
+
+    /**
+     * Returns the current time in the units used for task runtimes and trace
+     * timestamps, us if RTOS_TIME_US is defined, otherwise ms.
+     * 
+     * @returns Time_t the current time
+     */
+    Time_t stamp();
+
+    /**
+     * Returns the current time in ms as a 64 bit value that does not wrap 
+     * around. If RTOS_TIME_32 is defined this takes longer to read than 
+     * `now`, so it should only be used where absolute time is required.
+     * 
      * @returns i64 the current time
      */
-    i64 now();
+    i64 now64();
     
     /**
      * Puts the processor into Idle Mode.
@@ -44,12 +115,16 @@ namespace Time {
 
     /**
      * Idles for `time` from `from`. If time has already passed the idle time
-     * will be reduced accordingly. Produces an idle trace.
+     * will be reduced accordingly. Produces an idle trace. If RTOS_TICKLESS 
+     * is defined the millisecond tick is suspended for the idle period. If
+     * RTOS_DEEP_SLEEP is defined the deepest sleep mode that fits the idle
+     * period and RTOS_SLEEP_LATENCY_MS is used, and the wake trace records
+     * how late the processor woke up.
      * 
-     * @param i64 from the time to idle from
-     * @param i64 time the amount of time to idle for
+     * @param Time_t       from the time to idle from
+     * @param Time_Delta_t time the amount of time to idle for
      */
-    void idle(i64 from, i64 time);
+    void idle(Time_t from, Time_Delta_t time);
 
 }}
 
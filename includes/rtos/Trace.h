@@ -14,25 +14,37 @@ namespace RTOS {
         Def_Task,  // The creation of a task
         Def_Event, // The definition of an event
         Def_Alloc, // The allocation of memory
+        Def_Queue, // The creation of a message queue
         // Marks
-        Mark_Init,  // The start of the RTOS
+        Mark_Init,  // The start of the RTOS, the us per unit of trace time and whether starts report latency
         Mark_Halt,  // RTOS exucution is about to stop
-        Mark_Start, // The start of a task
-        Mark_Stop,  // The end of a task
+        Mark_Start, // The start of a task and its latency from release (us, RTOS_LATCH)
+        Mark_Stop,  // The end of a task and the most scratch memory it has used
         Mark_Event, // The occurence of an event
-        Mark_Idle,  // Scheduled idle time
-        Mark_Wake,  // Woke up from idle time
+        Mark_Idle,  // Scheduled idle time and the sleep mode used
+        Mark_Wake,  // Woke up from idle time and how late the wakeup was
+        Mark_Admit, // The result, utilization (per mille) and cost (us) of an admission test
+        Mark_Histogram, // The runtime histogram of a task
+        Mark_Full,  // A message was not sent because its queue was full
+        Mark_Exhausted, // The event server ran out of budget and its overrun (us)
+        Mark_Heap,  // A heap block was allocated (bytes > 0) or freed (bytes < 0)
+        Mark_Stack, // A new lowest stack address and the bytes left below it
         // Errors
         Error_Max_Event,       // Maximum number of events exceeded
         Error_Undefined_Event, // Undefined event dispatched
         Error_Max_Alloc,       // Maximum memory allocation exceeded
         Error_Max_Pool,        // Maximum pool allocation exceeded
         Error_Null_Pool,       // Null pool or chunk pointer passed as argument
+        Error_Max_Heap,        // No heap block large enough (RTOS_HEAP)
+        Error_Max_Scratch,     // Scratch memory exhausted (RTOS_SCRATCH)
         Error_Max_Task,        // Maximum tasks exceeded
         Error_Null_Task,       // Null task passed as argument
         Error_Invalid_Task,    // Invalid task configuration provided
-        Error_Duplicate_Event, // Two tasks act on the same event
+        Error_Duplicate_Event, // Deprecated, unused since events fan out to every subscriber
         Error_Missed,          // A task schedule was missed
+        Error_Deadline,        // A task finished after its deadline (RTOS_EDF)
+        Error_Overload,        // A task was rejected by admission control
+        Error_Overrun,         // A task ran past its budget (RTOS_BUDGET)
         // Debug
         Debug_Message, // Used to send messages to the tracer
     };
@@ -63,22 +75,38 @@ namespace RTOS {
                 struct { const char * handle; u8 instance; } task;
                 struct { const char * handle; Event_t event; } event;
                 struct { const char * handle; u16 bytes; } alloc;
+                struct { const char * handle; u8 queue; } queue;
             } def;
             union {
                 struct { u64 time; };
-                struct { u64 time; u16 heap; } init;
+                struct { u64 time; u16 heap; u16 resolution; u8 latency; } init;
                 struct { u64 time; } halt;
+                #ifdef RTOS_LATCH
+                struct { u64 time; u8 instance; u16 latency; } start;
+                #else
                 struct { u64 time; u8 instance; } start;
-                struct { u64 time; u8 instance; } stop;
+                #endif
+                struct { u64 time; u8 instance; u16 scratch; } stop;
                 struct { u64 time; Event_t event; } event;
-                struct { u64 time; } idle;
-                struct { u64 time; } wake;
+                struct { u64 time; u8 mode; } idle;
+                struct { u64 time; u8 mode; u16 latency; } wake;
+                struct { u64 time; u8 instance; u8 result; u16 utilization; u16 cost; } admit;
+                struct { u64 time; u8 instance; u8 buckets[TASK_HISTOGRAM_BUCKETS]; } histogram;
+                struct { u64 time; u8 queue; } full;
+                struct { u64 time; u16 debt; } exhausted;
+                struct { u64 time; i16 bytes; u16 available; u16 fragmentation; } heap;
+                struct { u64 time; u16 watermark; u16 free; } stack;
             } mark;
             union {
                 struct { Event_t event; } undefined_event;
-                struct { Event_t event; } duplicate_event;
+                struct { u16 bytes; } max_heap;
+                struct { u16 bytes; } max_scratch;
                 struct { u8 instance; } invalid_task;
+                struct { Event_t event; } duplicate_event;
                 struct { u8 instance; } missed;
+                struct { u8 instance; } deadline;
+                struct { u8 instance; u16 utilization; } overload;
+                struct { u8 instance; u16 elapsed; } overrun;
             } error;
             union {
                 struct { const char * message; };
@@ -0,0 +1 @@
+name = 'planner.py'
\ No newline at end of file
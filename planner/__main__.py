@@ -0,0 +1,13 @@
+from argparse import ArgumentParser
+
+from .planner import main
+
+# Program entry point for module
+if __name__ == "__main__":
+    parser = ArgumentParser(prog='planner', description='RTOS schedule planner picks the phase of each periodic task to minimize release jitter and writes them to a C++ header.')
+    parser.add_argument('tasks',           help='JSON task set, a list of {"name", "period", "wcet", "deadline"} in milliseconds')
+    parser.add_argument('--trace',  '-t', help='JSON trace recorded with `python3 -m tracer --noweb`, measured WCETs replace declared ones')
+    parser.add_argument('--output', '-o', help='header to write (default stdout)')
+    parser.add_argument('--step',   '-s', default=1, type=int, help='phase search step in milliseconds (default 1)')
+    parser.add_argument('--static', action='store_true', help='also emit a Static_Tasks_t set of the plan')
+    main(parser.parse_args())
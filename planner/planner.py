@@ -0,0 +1,213 @@
+from sys          import stderr
+from json         import load
+from math         import gcd
+from functools    import reduce
+from mekpie.cli   import panic
+
+HYPERPERIODS  = 4     # Hyperperiods simulated for every candidate plan
+MAX_RELEASES  = 20000 # Bound on the releases simulated for a candidate plan
+STATIC_FRAMES = 512   # Most frames in a Static_Tasks_t hyperperiod
+STATIC_TASKS  = 32    # Most tasks in a Static_Tasks_t set
+GUARD         = 'RTOS_PLAN_H'
+
+# Names a task cannot take, C++ keywords and the names the header defines
+RESERVED = {
+    'alignas', 'alignof', 'and', 'and_eq', 'asm', 'auto', 'bitand', 'bitor',
+    'bool', 'break', 'case', 'catch', 'char', 'char16_t', 'char32_t', 'class',
+    'compl', 'const', 'constexpr', 'const_cast', 'continue', 'decltype',
+    'default', 'delete', 'do', 'double', 'dynamic_cast', 'else', 'enum',
+    'explicit', 'export', 'extern', 'false', 'float', 'for', 'friend', 'goto',
+    'if', 'inline', 'int', 'long', 'mutable', 'namespace', 'new', 'noexcept',
+    'not', 'not_eq', 'nullptr', 'operator', 'or', 'or_eq', 'private',
+    'protected', 'public', 'register', 'reinterpret_cast', 'return', 'short',
+    'signed', 'sizeof', 'static', 'static_assert', 'static_cast', 'struct',
+    'switch', 'template', 'this', 'thread_local', 'throw', 'true', 'try',
+    'typedef', 'typeid', 'typename', 'union', 'unsigned', 'using', 'virtual',
+    'void', 'volatile', 'wchar_t', 'while', 'xor', 'xor_eq',
+    'minor_frame_ms', 'major_frame_ms', 'Static_Plan',
+}
+
+def lcm(a, b):
+    return a // gcd(a, b) * b
+
+def load_tasks(path):
+    with open(path) as file:
+        tasks = load(file)
+    for task in tasks:
+        if not task.get('name') or 'period' not in task:
+            panic(f'Every task needs a name and a period: {task}')
+        if int(task['period']) != task['period'] or task['period'] <= 0:
+            panic(f'Task {task["name"]} needs a whole, positive period')
+        task.setdefault('wcet', 0)
+        task.setdefault('deadline', task['period'])
+    return tasks
+
+# Returns the longest runtime seen for every task handle in a trace
+def measure_wcets(path):
+    with open(path) as file:
+        traces = load(file)
+    handles = {}
+    started = {}
+    wcets   = {}
+    for trace in traces:
+        if trace['name'] == 'Def_Task':
+            handles[trace['instance']] = trace['handle']
+        elif trace['name'] == 'Mark_Start':
+            started[trace['instance']] = trace['time']
+        elif trace['name'] == 'Mark_Stop' and trace['instance'] in started:
+            handle = handles.get(trace['instance'])
+            runtime = trace['time'] - started.pop(trace['instance'])
+            if handle is not None:
+                wcets[handle] = max(wcets.get(handle, 0), runtime)
+    return wcets
+
+# Simulates the periodic tasks of the RTOS with each task taking its WCET. 
+# Like Task::run, the next release of a task is its nominal release plus its
+# period, so a late start does not push back later releases. Returns the 
+# worst release jitter (how late a task starts after its nominal release) and
+# the worst response time of each task.
+def simulate(tasks, phases, horizon):
+    releases = [phase for phase in phases]
+    jitter   = [0] * len(tasks)
+    response = [0] * len(tasks)
+    time     = 0
+    count    = 0
+    while count < MAX_RELEASES:
+        # Tasks are run in release order, ties in the order they were dispatched
+        i = min(range(len(tasks)), key=lambda i: (releases[i], i))
+        if releases[i] > horizon:
+            break
+        start = max(time, releases[i])
+        jitter[i] = max(jitter[i], start - releases[i])
+        time = start + tasks[i]['wcet']
+        response[i] = max(response[i], time - releases[i])
+        releases[i] += tasks[i]['period']
+        count += 1
+    return jitter, response
+
+def score(tasks, phases, horizon):
+    jitter, response = simulate(tasks, phases, horizon)
+    missed = sum(1 for task, r in zip(tasks, response) if r > task['deadline'])
+    return (missed, max(jitter), sum(jitter))
+
+# Places the tasks one at a time, shortest period first, each at the phase 
+# that minimizes the worst jitter of the tasks placed so far
+def plan(tasks, step):
+    hyperperiod = reduce(lcm, (task['period'] for task in tasks), 1)
+    horizon     = hyperperiod * HYPERPERIODS
+    order       = sorted(range(len(tasks)), key=lambda i: (tasks[i]['period'], i))
+    phases      = [0] * len(tasks)
+    placed      = []
+    for i in order:
+        placed.append(i)
+        subset = [tasks[j] for j in sorted(placed)]
+        best   = None
+        for phase in range(0, tasks[i]['period'], step):
+            phases[i] = phase
+            candidate = score(subset, [phases[j] for j in sorted(placed)], horizon)
+            if best is None or candidate < best[0]:
+                best = (candidate, phase)
+        phases[i] = best[1]
+    jitter, response = simulate(tasks, phases, horizon)
+    minor = reduce(gcd, [task['period'] for task in tasks] + phases, 0)
+    return phases, jitter, response, minor, hyperperiod
+
+def identifier(name):
+    name = ''.join(c if c.isalnum() else '_' for c in name)
+    return '_' + name if name[0].isdigit() else name
+
+# Exits if two tasks map to the same identifier or one is reserved
+def check_names(tasks):
+    seen = {}
+    for task in tasks:
+        name = identifier(task['name'])
+        if name in RESERVED:
+            panic(f'Task {task["name"]} cannot be named {name}, it is reserved in C++ or by the plan')
+        if name in seen:
+            panic(f'Tasks {seen[name]} and {task["name"]} both become {name}, rename one')
+        seen[name] = task['name']
+
+# Exits if the plan does not fit a Static_Tasks_t set
+def check_static(tasks, minor, major):
+    if len(tasks) > STATIC_TASKS:
+        panic(f'A static task set holds at most {STATIC_TASKS} tasks, not {len(tasks)}')
+    frames = major // minor
+    if frames > STATIC_FRAMES:
+        panic(f'The static plan has {frames} frames of {minor} ms, at most {STATIC_FRAMES} fit, use periods with a larger common divisor or a larger --step')
+
+def format_ms(value):
+    return f'{value:g}'
+
+def emit_header(tasks, phases, jitter, response, minor, major, static):
+    lines = [
+        '#pragma once',
+        '',
+        f'#ifndef {GUARD}',
+        f'#define {GUARD}',
+        '',
+        '// Generated by `python3 -m planner`, do not edit.',
+        '//',
+        f'// Minor frame {minor} ms, major frame {major} ms, worst release jitter',
+        f'// {format_ms(max(jitter))} ms. Dispatch each task with its period_ms and delay_ms.',
+        '// The delay only offsets the first release, the RTOS clears it once the',
+        '// task has run.',
+        '',
+        '#include <RTOS.h>',
+        '',
+        'namespace RTOS {',
+        'namespace Plan {',
+        '',
+        f'    const u16 minor_frame_ms = {minor};',
+        f'    const u16 major_frame_ms = {major};',
+        '',
+    ]
+    for task, phase, j, r in zip(tasks, phases, jitter, response):
+        lines += [
+            f'    // {task["name"]}: wcet {format_ms(task["wcet"])} ms, worst jitter {format_ms(j)} ms, worst response {format_ms(r)} ms',
+            f'    namespace {identifier(task["name"])} {{',
+            f'        const u16 period_ms   = {task["period"]};',
+            f'        const i16 delay_ms    = {phase};',
+            f'        const i16 deadline_ms = {int(task["deadline"])};',
+            '    }',
+            '',
+        ]
+    if static:
+        for task in tasks:
+            lines.append(f'    void {identifier(task["name"])}_fn();')
+        lines += ['', '    typedef Static_Tasks_t<']
+        entries = [
+            f'        Static_Task_t<{identifier(task["name"])}_fn, {task["period"]}, {phase}>'
+            for task, phase in zip(tasks, phases)
+        ]
+        lines += [',\n'.join(entries), '    > Static_Plan;', '']
+    lines += [
+        '}}',
+        '',
+        f'#endif /* {GUARD} */',
+        '',
+    ]
+    return '\n'.join(lines)
+
+def main(args):
+    tasks = load_tasks(args.tasks)
+    check_names(tasks)
+    if args.trace:
+        wcets = measure_wcets(args.trace)
+        for task in tasks:
+            if task['name'] in wcets:
+                task['wcet'] = wcets[task['name']]
+            else:
+                print(f'No runs of {task["name"]} in trace, using declared WCET', file=stderr)
+    phases, jitter, response, minor, major = plan(tasks, max(args.step, 1))
+    if args.static:
+        check_static(tasks, minor, major)
+    for task, r in zip(tasks, response):
+        if r > task['deadline']:
+            print(f'Warning {task["name"]} misses its deadline ({format_ms(r)} > {task["deadline"]} ms)', file=stderr)
+    header = emit_header(tasks, phases, jitter, response, minor, major, args.static)
+    if args.output:
+        with open(args.output, 'w') as file:
+            file.write(header)
+        print(f'Wrote plan to {args.output} - worst release jitter {format_ms(max(jitter))} ms', file=stderr)
+    else:
+        print(header, end='')
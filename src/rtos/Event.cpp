@@ -6,9 +6,13 @@ namespace Event {
 
     static u8 event_count = 0;
 
+    // Events dispatched while no task listened for them, kept for the first
+    // task that does
+    static Event_t unclaimed = 0;
+
     Event_t init(const char * handle) {
 
-        Event_t event = BV(event_count++);
+        Event_t event = (Event_t) 1 << event_count++;
 
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -31,20 +35,120 @@ namespace Event {
         return event;
     }
 
+    // Appends `task` to the event queue. MUST BE CALLED IN AN ATOMIC BLOCK!
+    static void enqueue(Task_t * task) {
+        Event_Queue_t * queue = &Registers::event_queue;
+        Memory::Pool::cons(task, nullptr);
+        if (queue->head == nullptr) {
+            queue->head = task;
+        } else {
+            Memory::Pool::cons(queue->tail, task);
+        }
+        queue->tail = task;
+        #ifdef RTOS_EDF
+        // The deadline of an event task starts when its event is dispatched
+        if (!task->impl.ready) {
+            task->impl.deadline = Time::now() + Task::deadline(task);
+        }
+        #endif
+    }
+
+    // Adds `events` to the pending events of `task`, queuing it if they are 
+    // its first. MUST BE CALLED IN AN ATOMIC BLOCK!
+    static void deliver(Task_t * task, Event_t events) {
+        // A task is queued once however many events it has pending
+        #ifdef RTOS_PREEMPT
+        // Preemptive tasks are released by Preempt::schedule instead
+        if (!task->impl.pending && !task->priority) {
+            enqueue(task);
+        }
+        #else
+        if (!task->impl.pending) {
+            enqueue(task);
+        }
+        #endif
+        task->impl.pending |= events;
+    }
+
+    void claim(Task_t * task) {
+        Event_t events = task->events & unclaimed;
+        if (events) {
+            unclaimed &= ~events;
+            deliver(task, events);
+        }
+    }
+
+    Task_t * next() {
+        return Registers::event_queue.head;
+    }
+
+    void pop() {
+        Event_Queue_t * queue = &Registers::event_queue;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (queue->head != nullptr) {
+                queue->head = Task::cdr(queue->head);
+                if (queue->head == nullptr) {
+                    queue->tail = nullptr;
+                }
+            }
+        }
+    }
+
+    bool waiting() {
+        // Pushed work is dispatched from the main loop
+        if (Ring::pushed()) {
+            return true;
+        }
+        #ifdef RTOS_SERVER
+        // Waiting tasks cannot run until the server is replenished
+        if (Server::depleted()) {
+            return false;
+        }
+        #endif
+        return Registers::event_queue.head != nullptr;
+    }
+
     void dispatch(Event_t e) {
-        Registers::events |= e;
+        // Fan the event out to every task waiting for it. Interrupts are only
+        // held off for one task at a time. The list is walked from the end,
+        // as unsubscribing moves the last task into the freed slot: a task is
+        // then at worst visited twice, never skipped. A task that subscribes
+        // meanwhile is added behind the walk and counts as subscribing after
+        // the event.
+        Task_List_t * tasks = &Registers::event_tasks;
+        Event_t claimed = 0;
+        for (u8 i = tasks->size; i > 0; i--) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                if (i <= tasks->size) {
+                    Task_t * task = tasks->data[i - 1];
+                    Event_t events = task->events & e;
+                    if (events) {
+                        deliver(task, events);
+                        claimed |= events;
+                    }
+                }
+            }
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            unclaimed |= e & ~claimed;
+            #ifdef RTOS_PREEMPT
+            // Run a preemptive task waiting on `e` right away
+            Preempt::schedule();
+            #endif
+        }
 
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Event;
-            Registers::trace.mark.event.time = Time::now();
+            Registers::trace.mark.event.time = Time::stamp();
             Registers::trace.mark.event.event = e;
             trace();
         }
         #endif
 
         #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_EVENT)
-        if (e >= (Event_t) BV(event_count)) {
+        if (event_count < RTOS_MAX_EVENTS && e >= ((Event_t) 1 << event_count)) {
             ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
                 Registers::trace.tag = Error_Undefined_Event;
                 error();
@@ -53,4 +157,79 @@ namespace Event {
         #endif
     }
 
+    namespace Ring {
+
+        // Keeps the compiler from moving buffer accesses past an index update
+        #define RING_BARRIER() asm volatile("" ::: "memory")
+
+        // Every ring, most recently initialized first
+        static Ring_t * rings = nullptr;
+
+        Ring_t * init(const char * handle, Event_t event, u8 capacity) {
+            Ring_t * ring = (Ring_t *) Memory::static_alloc(handle, sizeof(Ring_t));
+            ring->event     = event;
+            ring->capacity  = capacity;
+            ring->dropped   = 0;
+            ring->impl.head = 0;
+            ring->impl.tail = 0;
+            ring->impl.pushed = false;
+            ring->impl.data = (Work_t *) Memory::static_alloc(handle, sizeof(Work_t) * capacity);
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                ring->impl.next = rings;
+                rings = ring;
+            }
+            return ring;
+        }
+
+        bool push(Ring_t * ring, Event_t event, u16 payload) {
+            u8 tail = ring->impl.tail;
+            if ((u8) (tail - ring->impl.head) == ring->capacity) {
+                ring->dropped++;
+                return false;
+            }
+            Work_t * work = &ring->impl.data[tail & (ring->capacity - 1)];
+            work->event   = event;
+            work->payload = payload;
+            work->time    = Time::now_us32();
+            // Publish the item only once it is written
+            RING_BARRIER();
+            ring->impl.tail = tail + 1;
+            // The main loop dispatches the event, not the interrupt
+            ring->impl.pushed = true;
+            return true;
+        }
+
+        void collect() {
+            for (Ring_t * ring = rings; ring != nullptr; ring = ring->impl.next) {
+                if (ring->impl.pushed) {
+                    // Cleared first, so a push from here on flags it again
+                    ring->impl.pushed = false;
+                    dispatch(ring->event);
+                }
+            }
+        }
+
+        bool pushed() {
+            for (Ring_t * ring = rings; ring != nullptr; ring = ring->impl.next) {
+                if (ring->impl.pushed) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool pop(Ring_t * ring, Work_t * work) {
+            u8 head = ring->impl.head;
+            if (head == ring->impl.tail) {
+                return false;
+            }
+            *work = ring->impl.data[head & (ring->capacity - 1)];
+            // Free the slot only once it is copied
+            RING_BARRIER();
+            ring->impl.head = head + 1;
+            return true;
+        }
+
+    }
+
 }}
\ No newline at end of file
@@ -1,6 +1,15 @@
 #include <RTOS.h>
 #include <Private.h>
 
+#ifdef RTOS_STACK_PAINT
+// The end of .bss and the top of the malloc heap, which is only linked in if
+// malloc is used
+extern "C" {
+    extern char __heap_start;
+    extern char * __brkval __attribute__((weak));
+}
+#endif
+
 namespace RTOS {
 namespace Memory {
 
@@ -33,6 +42,118 @@ namespace Memory {
         return ptr;
     }
 
+    #ifdef RTOS_SCRATCH
+    namespace Scratch {
+
+        static u8 * data;
+        static u16 used = 0;
+
+        void init() {
+            data = (u8 *) static_alloc("RTOS::Memory::Scratch", RTOS_SCRATCH_BYTES);
+        }
+
+        u16 mark() {
+            return used;
+        }
+
+        void rewind(u16 mark) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                used = mark;
+            }
+        }
+
+    }
+
+    void * scratch(u16 bytes) {
+
+        void * ptr = nullptr;
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (bytes <= RTOS_SCRATCH_BYTES - Scratch::used) {
+                ptr = Scratch::data + Scratch::used;
+                Scratch::used += bytes;
+            }
+        }
+
+        #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_ALLOC)
+        if (ptr == nullptr) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Max_Scratch;
+                Registers::trace.error.max_scratch.bytes = bytes;
+                error();
+            }
+        }
+        #endif
+
+        return ptr;
+    }
+    #endif
+
+    #ifdef RTOS_STACK_PAINT
+    namespace Stack {
+
+        // Painted over the free memory between the heap and the stack
+        #define STACK_PATTERN 0xC5
+        // The most bytes checked by each scan
+        #define STACK_SCAN_BYTES 32
+
+        static u8 * watermark; // The lowest byte the stack is known to have reached
+        static u8 * cursor;    // The next byte to check
+
+        // Returns the end of the memory used by .data, .bss and malloc
+        static inline u8 * bottom() {
+            if (&__brkval != nullptr && __brkval != nullptr) {
+                return (u8 *) __brkval;
+            }
+            return (u8 *) &__heap_start;
+        }
+
+        void paint() {
+            u8 * sp = (u8 *) SP;
+            for (u8 * byte = bottom(); byte < sp; byte++) {
+                *byte = STACK_PATTERN;
+            }
+            watermark = sp;
+            cursor = bottom();
+        }
+
+        void scan() {
+            u8 * low = bottom();
+            if (cursor < low) {
+                cursor = low;
+            }
+            for (u8 i = 0; i < STACK_SCAN_BYTES; i++) {
+                if (cursor >= watermark) {
+                    // A full pass found nothing new, start the next one
+                    cursor = low;
+                    return;
+                }
+                if (*cursor != STACK_PATTERN) {
+                    watermark = cursor;
+                    cursor = low;
+                    #ifdef RTOS_TRACE
+                    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                        Registers::trace.tag = Mark_Stack;
+                        Registers::trace.mark.stack.time = Time::stamp();
+                        Registers::trace.mark.stack.watermark = (u16) (size_t) watermark;
+                        Registers::trace.mark.stack.free = stack_free();
+                        trace();
+                    }
+                    #endif
+                    return;
+                }
+                cursor++;
+            }
+        }
+
+    }
+
+    u16 stack_free() {
+        u8 * low = Stack::bottom();
+        return Stack::watermark > low ? (u16) (Stack::watermark - low) : 0;
+    }
+    #endif
+
     namespace Pool {
 
         // Get chunk of a given node
@@ -45,14 +166,79 @@ namespace Memory {
             Pool_Node_t * cdr; // A pointer to the next available chunk's pool_node
         };
         
-        Pool_t * init(const char * handle, u8 chunk, u8 chunks) {
+        // The number of bitmap bytes of a bitmap pool
+        #define POOL_BITMAP_BYTES(pool) (((pool)->chunks + 7) / 8)
 
-            Pool_t * pool = (Pool_t *) static_alloc(handle, sizeof(Pool_t));
+        // Sets a bit for every chunk of a new bitmap pool
+        static void init_bitmap(Pool_t * pool) {
+            u8 * bitmap = (u8 *) pool->impl.head;
+            u8 bytes = POOL_BITMAP_BYTES(pool);
+            for (u8 i = 0; i < bytes; i++) {
+                bitmap[i] = 0xFF;
+            }
+            if (pool->chunks % 8) {
+                bitmap[bytes - 1] = (1 << (pool->chunks % 8)) - 1;
+            }
+        }
 
-            u8 step = chunk + sizeof(Pool_Node_t);
+        // Takes the lowest free chunk of a bitmap pool, or nullptr if every
+        // chunk is allocated
+        static void * alloc_bitmap(Pool_t * pool) {
+            u8 * bitmap = (u8 *) pool->impl.head;
+            u8 bytes = POOL_BITMAP_BYTES(pool);
+            for (u8 i = 0; i < bytes; i++) {
+                u8 free = bitmap[i];
+                if (free) {
+                    u8 bit = __builtin_ctz(free);
+                    bitmap[i] = free & (free - 1);
+                    return pool->impl.data + (u16) (i * 8 + bit) * pool->chunk;
+                }
+            }
+            return nullptr;
+        }
+
+        static void dealloc_bitmap(Pool_t * pool, void * chunk) {
+            u8 * bitmap = (u8 *) pool->impl.head;
+            u8 index = (u16) ((u8 *) chunk - pool->impl.data) / pool->chunk;
+            bitmap[index / 8] |= 1 << (index % 8);
+        }
+
+        // Takes one more chunk for an empty growing pool from the virtual heap
+        static void grow(Pool_t * pool) {
+            Pool_Node_t * node = (Pool_Node_t *) static_alloc(
+                pool->impl.handle, 
+                pool->chunk + sizeof(Pool_Node_t)
+            );
+            node->cdr = nullptr;
+            pool->impl.head = node;
+            pool->impl.grown++;
+        }
+
+        Pool_t * init(const char * handle, u8 chunk, u8 chunks, Pool_Kind_t kind) {
+
+            Pool_t * pool = (Pool_t *) static_alloc(handle, sizeof(Pool_t));
 
             pool->chunk     = chunk;
             pool->chunks    = chunks;
+            pool->impl.kind = kind;
+            pool->impl.grown  = 0;
+            pool->impl.handle = handle;
+
+            if (kind == Pool_Grow) {
+                pool->impl.data = nullptr;
+                pool->impl.head = nullptr;
+                return pool;
+            }
+
+            if (kind == Pool_Bitmap) {
+                pool->impl.data = (u8 *) static_alloc(handle, chunks * chunk);
+                pool->impl.head = static_alloc(handle, POOL_BITMAP_BYTES(pool));
+                init_bitmap(pool);
+                return pool;
+            }
+
+            u8 step = chunk + sizeof(Pool_Node_t);
+
             pool->impl.data = (u8 *) static_alloc(handle, chunks * step);
             pool->impl.head = (Pool_Node_t *) pool->impl.data;
 
@@ -79,6 +265,26 @@ namespace Memory {
                     error();
                 }
             }
+            #endif
+
+            if (pool->impl.kind == Pool_Bitmap) {
+                void * chunk = alloc_bitmap(pool);
+                #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_POOL)
+                if (chunk == nullptr) {
+                    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                        Registers::trace.tag = Error_Max_Pool;
+                        error();
+                    }
+                }
+                #endif
+                return chunk;
+            }
+
+            if (pool->impl.head == nullptr && pool->impl.kind == Pool_Grow && pool->impl.grown < pool->chunks) {
+                grow(pool);
+            }
+
+            #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_POOL)
             if (pool->impl.head == nullptr) {
                 ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
                     Registers::trace.tag = Error_Max_Pool;
@@ -105,6 +311,11 @@ namespace Memory {
             }
             #endif
 
+            if (pool->impl.kind == Pool_Bitmap) {
+                dealloc_bitmap(pool, chunk);
+                return;
+            }
+
             Pool_Node_t * node = POOL_CHUNK_NODE(chunk);
             node->cdr = (Pool_Node_t *) pool->impl.head;
             pool->impl.head = node;
@@ -146,6 +357,362 @@ namespace Memory {
             return chunk_car;
         }
 
+        void define(const char * handle, u16 bytes) {
+            #ifdef RTOS_TRACE
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Def_Alloc;
+                Registers::trace.def.alloc.handle = handle;
+                Registers::trace.def.alloc.bytes = bytes;
+                trace();
+            }
+            #endif
+        }
+
+        void overflow() {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Max_Pool;
+                error();
+            }
+        }
+
+        void null_chunk() {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Null_Pool;
+                error();
+            }
+        }
+
+    }
+
+    #ifdef RTOS_HEAP
+    namespace Heap {
+
+        // Each power of two size range is split into 1 << HEAP_SL_LOG2 bins
+        #define HEAP_SL_LOG2 2
+        #define HEAP_SL_COUNT (1 << HEAP_SL_LOG2)
+        // Block sizes are kept even so that bit 0 can mark a free block
+        #define HEAP_FREE 1
+        #define HEAP_SIZE(block) ((block)->size & ~HEAP_FREE)
+        // The header of a used block, a free block also holds its free links
+        #define HEAP_HEADER offsetof(Block_t, next_free)
+        // The smallest block, which must be able to hold the free links
+        #define HEAP_MIN_BLOCK (sizeof(Block_t) - HEAP_HEADER)
+        // Sizes below HEAP_SMALL share the first level, split linearly
+        #define HEAP_SMALL (HEAP_MIN_BLOCK << HEAP_SL_LOG2)
+
+        typedef struct Block_t Block_t;
+        struct Block_t {
+            Block_t * prev;      // The physically previous block, or nullptr
+            u16 size;            // The bytes after the header, and HEAP_FREE
+            Block_t * next_free; // The next block in the same bin (free only)
+            Block_t * prev_free; // The previous block in the same bin (free only)
+        };
+
+        // Returns the index of the highest set bit of a non zero `x`
+        static inline u8 fls(u16 x) {
+            return (u8) (sizeof(unsigned) * 8 - 1 - __builtin_clz(x));
+        }
+
+        // Returns the index of the lowest set bit of a non zero `x`
+        static inline u8 ffs(u16 x) {
+            return (u8) __builtin_ctz(x);
+        }
+
+        static constexpr u8 log2(u16 x) {
+            return x <= 1 ? 0 : 1 + log2(x >> 1);
+        }
+
+        // The number of first level bins, one for the small sizes and one for
+        // every power of two up to the heap size
+        #define HEAP_FL_SHIFT log2(HEAP_SMALL)
+        #define HEAP_FL_COUNT (log2(RTOS_HEAP_BYTES) - HEAP_FL_SHIFT + 2)
+
+        static u16 fl_bitmap;
+        static u8 sl_bitmap[HEAP_FL_COUNT];
+        static Block_t * bins[HEAP_FL_COUNT][HEAP_SL_COUNT];
+        static u16 free_bytes;
+
+        static inline Block_t * block_of(void * ptr) {
+            return (Block_t *) ((u8 *) ptr - HEAP_HEADER);
+        }
+
+        static inline void * ptr_of(Block_t * block) {
+            return (u8 *) block + HEAP_HEADER;
+        }
+
+        static inline Block_t * next_of(Block_t * block) {
+            return (Block_t *) ((u8 *) ptr_of(block) + HEAP_SIZE(block));
+        }
+
+        // Finds the bin holding blocks of `size`
+        static inline void bin_of(u16 size, u8 * fl, u8 * sl) {
+            if (size < HEAP_SMALL) {
+                *fl = 0;
+                *sl = size / (HEAP_SMALL / HEAP_SL_COUNT);
+            } else {
+                u8 f = fls(size);
+                *sl = (size >> (f - HEAP_SL_LOG2)) ^ HEAP_SL_COUNT;
+                *fl = f - HEAP_FL_SHIFT + 1;
+            }
+        }
+
+        // Adds a free block to the front of its bin
+        static void insert(Block_t * block) {
+            u8 fl, sl;
+            bin_of(HEAP_SIZE(block), &fl, &sl);
+            Block_t * head = bins[fl][sl];
+            block->size |= HEAP_FREE;
+            block->prev_free = nullptr;
+            block->next_free = head;
+            if (head != nullptr) {
+                head->prev_free = block;
+            }
+            bins[fl][sl] = block;
+            fl_bitmap |= 1 << fl;
+            sl_bitmap[fl] |= 1 << sl;
+            free_bytes += HEAP_SIZE(block);
+        }
+
+        // Takes a free block out of its bin
+        static void remove(Block_t * block) {
+            u8 fl, sl;
+            bin_of(HEAP_SIZE(block), &fl, &sl);
+            if (block->prev_free != nullptr) {
+                block->prev_free->next_free = block->next_free;
+            } else {
+                bins[fl][sl] = block->next_free;
+            }
+            if (block->next_free != nullptr) {
+                block->next_free->prev_free = block->prev_free;
+            }
+            if (bins[fl][sl] == nullptr) {
+                sl_bitmap[fl] &= ~(1 << sl);
+                if (sl_bitmap[fl] == 0) {
+                    fl_bitmap &= ~(1 << fl);
+                }
+            }
+            block->size &= ~HEAP_FREE;
+            free_bytes -= HEAP_SIZE(block);
+        }
+
+        // Returns the first block of the smallest bin whose blocks all fit 
+        // `size`, or nullptr if there is none
+        static Block_t * search(u16 size) {
+            u8 fl, sl;
+            // Round up to the next bin so any block in it fits
+            if (size >= HEAP_SMALL) {
+                size += (1 << (fls(size) - HEAP_SL_LOG2)) - 1;
+            } else {
+                size += HEAP_SMALL / HEAP_SL_COUNT - 1;
+            }
+            bin_of(size, &fl, &sl);
+            if (fl >= HEAP_FL_COUNT) {
+                return nullptr;
+            }
+            u8 sl_map = sl_bitmap[fl] & (0xFF << sl);
+            if (sl_map == 0) {
+                u16 fl_map = fl_bitmap & (0xFFFF << (fl + 1));
+                if (fl_map == 0) {
+                    return nullptr;
+                }
+                fl = ffs(fl_map);
+                sl_map = sl_bitmap[fl];
+            }
+            return bins[fl][ffs(sl_map)];
+        }
+
+        #ifdef RTOS_TRACE
+        // MUST BE CALLED IN AN ATOMIC BLOCK!
+        static void trace_heap(i16 bytes) {
+            Registers::trace.tag = Mark_Heap;
+            Registers::trace.mark.heap.time = Time::stamp();
+            Registers::trace.mark.heap.bytes = bytes;
+            Registers::trace.mark.heap.available = free_bytes;
+            Registers::trace.mark.heap.fragmentation = fragmentation();
+            trace();
+        }
+        #endif
+
+        void init() {
+            u8 * data = (u8 *) static_alloc("RTOS::Memory::Heap", RTOS_HEAP_BYTES);
+            // One free block spans the heap, ended by an empty used block so 
+            // that the last block is never merged past the heap
+            Block_t * block = (Block_t *) data;
+            block->prev = nullptr;
+            block->size = (RTOS_HEAP_BYTES - 2 * HEAP_HEADER) & ~HEAP_FREE;
+            Block_t * end = next_of(block);
+            end->prev = block;
+            end->size = 0;
+            insert(block);
+        }
+
+        void * alloc(u16 bytes) {
+
+            u16 size = (max(bytes, (u16) HEAP_MIN_BLOCK) + 1) & ~HEAP_FREE;
+            Block_t * block = nullptr;
+
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                if (bytes <= RTOS_HEAP_BYTES) {
+                    block = search(size);
+                }
+                if (block != nullptr) {
+                    remove(block);
+                    // Split off the rest if it can stand as a block
+                    if (HEAP_SIZE(block) >= size + HEAP_HEADER + HEAP_MIN_BLOCK) {
+                        Block_t * rest = (Block_t *) ((u8 *) ptr_of(block) + size);
+                        rest->prev = block;
+                        rest->size = HEAP_SIZE(block) - size - HEAP_HEADER;
+                        next_of(rest)->prev = rest;
+                        block->size = size;
+                        insert(rest);
+                    }
+                    #ifdef RTOS_TRACE
+                    trace_heap((i16) HEAP_SIZE(block));
+                    #endif
+                }
+            }
+
+            if (block == nullptr) {
+                #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_ALLOC)
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    Registers::trace.tag = Error_Max_Heap;
+                    Registers::trace.error.max_heap.bytes = bytes;
+                    error();
+                }
+                #endif
+                return nullptr;
+            }
+            return ptr_of(block);
+        }
+
+        void free(void * ptr) {
+
+            if (ptr == nullptr) {
+                return;
+            }
+
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Block_t * block = block_of(ptr);
+                #ifdef RTOS_TRACE
+                i16 bytes = (i16) HEAP_SIZE(block);
+                #endif
+                // Merge with the next block
+                Block_t * next = next_of(block);
+                if (next->size & HEAP_FREE) {
+                    remove(next);
+                    block->size += HEAP_HEADER + next->size;
+                    next_of(block)->prev = block;
+                }
+                // Merge with the previous block
+                Block_t * prev = block->prev;
+                if (prev != nullptr && (prev->size & HEAP_FREE)) {
+                    remove(prev);
+                    prev->size += HEAP_HEADER + block->size;
+                    next_of(prev)->prev = prev;
+                    block = prev;
+                }
+                insert(block);
+                #ifdef RTOS_TRACE
+                trace_heap(-bytes);
+                #endif
+            }
+        }
+
+        u16 available() {
+            return free_bytes;
+        }
+
+        u16 fragmentation() {
+            u16 total = free_bytes;
+            if (total == 0) {
+                return 0;
+            }
+            u8 fl = fls(fl_bitmap);
+            u16 largest = HEAP_SIZE(bins[fl][fls(sl_bitmap[fl])]);
+            return (u16) (1000 - (u32) largest * 1000 / total);
+        }
+
+    }
+    #endif
+
+    namespace Queue {
+
+        static u8 queue_count = 0;
+
+        Queue_t * init(const char * handle, Event_t event, u8 capacity) {
+
+            Queue_t * queue = (Queue_t *) static_alloc(handle, sizeof(Queue_t));
+
+            queue->event     = event;
+            queue->capacity  = capacity;
+            queue->impl.id   = queue_count++;
+            queue->impl.size = 0;
+            queue->impl.head = nullptr;
+            queue->impl.tail = nullptr;
+
+            #ifdef RTOS_TRACE
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Def_Queue;
+                Registers::trace.def.queue.handle = handle;
+                Registers::trace.def.queue.queue = queue->impl.id;
+                trace();
+            }
+            #endif
+
+            return queue;
+        }
+
+        bool send(Queue_t * queue, void * chunk) {
+
+            bool full = false;
+
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                if (queue->impl.size >= queue->capacity) {
+                    full = true;
+                } else {
+                    Pool::cons(chunk, nullptr);
+                    if (queue->impl.head == nullptr) {
+                        queue->impl.head = chunk;
+                    } else {
+                        Pool::cons(queue->impl.tail, chunk);
+                    }
+                    queue->impl.tail = chunk;
+                    queue->impl.size++;
+                }
+            }
+
+            if (full) {
+                #ifdef RTOS_TRACE
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    Registers::trace.tag = Mark_Full;
+                    Registers::trace.mark.full.time = Time::stamp();
+                    Registers::trace.mark.full.queue = queue->impl.id;
+                    trace();
+                }
+                #endif
+                return false;
+            }
+
+            // A receiver that is already queued is not queued again
+            Event::dispatch(queue->event);
+            return true;
+        }
+
+        void * receive(Queue_t * queue) {
+            void * chunk;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                chunk = queue->impl.head;
+                if (chunk != nullptr) {
+                    queue->impl.head = Pool::cdr(chunk);
+                    if (queue->impl.head == nullptr) {
+                        queue->impl.tail = nullptr;
+                    }
+                    queue->impl.size--;
+                }
+            }
+            return chunk;
+        }
+
     }
 
 }}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include <RTOS.h>
+#include <Private.h>
+
+#ifdef RTOS_PREEMPT
+
+// The number of bytes pushed by switch_context (r0-r31 and SREG, plus RAMPZ
+// and EIND on devices with a 3 byte program counter)
+#if defined(__AVR_3_BYTE_PC__)
+    #define CONTEXT_BYTES 35
+#else
+    #define CONTEXT_BYTES 33
+#endif
+
+// Symbols shared with the context switch assembly
+extern "C" {
+    u8 * volatile rtos_stack_pointer;
+    void rtos_select_context();
+}
+
+namespace RTOS {
+namespace Preempt {
+
+    enum Context_State_t {
+        Context_Free,    // The slot has no task
+        Context_Idle,    // Waiting to be released
+        Context_Ready,   // Released but not yet started
+        Context_Running, // Running or preempted by a higher priority context
+        Context_Dead,    // Finished and waiting to be reclaimed
+    };
+
+    typedef struct Context_t Context_t;
+    struct Context_t {
+        Task_t * task; // The preemptive task, nullptr for the main context
+        u8 * sp;       // The saved stack pointer
+        u8 * stack;    // The stack buffer
+        u8 state;      // The Context_State_t of this context
+    };
+
+    // Context 0 is the main loop (and every run-to-completion task), which
+    // runs on the main stack at priority 0
+    static Context_t contexts[RTOS_PREEMPT_TASKS + 1];
+    static u8 current = 0;
+    static u8 next = 0;
+
+    // Memory pool used for the allocation of task stacks
+    static Memory::Pool_t * stack_pool;
+
+    static inline u8 priority(u8 context) {
+        return context == 0 ? 0 : contexts[context].task->priority;
+    }
+
+    // Saves the current context on its stack, switches to the stack of
+    // `next` and restores the context saved there. Interrupts stay disabled
+    // until the restored context re-enables them. MUST BE CALLED WITH
+    // INTERRUPTS DISABLED!
+    static void switch_context() __attribute__((naked, noinline));
+    static void switch_context() {
+        asm volatile(
+            "push r0                  \n\t"
+            "in   r0, __SREG__        \n\t"
+            "push r0                  \n\t"
+            #if defined(__AVR_3_BYTE_PC__)
+            "in   r0, %[rampz]        \n\t"
+            "push r0                  \n\t"
+            "in   r0, %[eind]         \n\t"
+            "push r0                  \n\t"
+            #endif
+            "push r1                  \n\t"
+            "clr  r1                  \n\t"
+            "push r2                  \n\t"
+            "push r3                  \n\t"
+            "push r4                  \n\t"
+            "push r5                  \n\t"
+            "push r6                  \n\t"
+            "push r7                  \n\t"
+            "push r8                  \n\t"
+            "push r9                  \n\t"
+            "push r10                 \n\t"
+            "push r11                 \n\t"
+            "push r12                 \n\t"
+            "push r13                 \n\t"
+            "push r14                 \n\t"
+            "push r15                 \n\t"
+            "push r16                 \n\t"
+            "push r17                 \n\t"
+            "push r18                 \n\t"
+            "push r19                 \n\t"
+            "push r20                 \n\t"
+            "push r21                 \n\t"
+            "push r22                 \n\t"
+            "push r23                 \n\t"
+            "push r24                 \n\t"
+            "push r25                 \n\t"
+            "push r26                 \n\t"
+            "push r27                 \n\t"
+            "push r28                 \n\t"
+            "push r29                 \n\t"
+            "push r30                 \n\t"
+            "push r31                 \n\t"
+            "in   r26, __SP_L__       \n\t"
+            "in   r27, __SP_H__       \n\t"
+            "sts  rtos_stack_pointer, r26   \n\t"
+            "sts  rtos_stack_pointer+1, r27 \n\t"
+            "call rtos_select_context \n\t"
+            "lds  r26, rtos_stack_pointer   \n\t"
+            "lds  r27, rtos_stack_pointer+1 \n\t"
+            "out  __SP_L__, r26       \n\t"
+            "out  __SP_H__, r27       \n\t"
+            "pop  r31                 \n\t"
+            "pop  r30                 \n\t"
+            "pop  r29                 \n\t"
+            "pop  r28                 \n\t"
+            "pop  r27                 \n\t"
+            "pop  r26                 \n\t"
+            "pop  r25                 \n\t"
+            "pop  r24                 \n\t"
+            "pop  r23                 \n\t"
+            "pop  r22                 \n\t"
+            "pop  r21                 \n\t"
+            "pop  r20                 \n\t"
+            "pop  r19                 \n\t"
+            "pop  r18                 \n\t"
+            "pop  r17                 \n\t"
+            "pop  r16                 \n\t"
+            "pop  r15                 \n\t"
+            "pop  r14                 \n\t"
+            "pop  r13                 \n\t"
+            "pop  r12                 \n\t"
+            "pop  r11                 \n\t"
+            "pop  r10                 \n\t"
+            "pop  r9                  \n\t"
+            "pop  r8                  \n\t"
+            "pop  r7                  \n\t"
+            "pop  r6                  \n\t"
+            "pop  r5                  \n\t"
+            "pop  r4                  \n\t"
+            "pop  r3                  \n\t"
+            "pop  r2                  \n\t"
+            "pop  r1                  \n\t"
+            #if defined(__AVR_3_BYTE_PC__)
+            "pop  r0                  \n\t"
+            "out  %[eind], r0         \n\t"
+            "pop  r0                  \n\t"
+            "out  %[rampz], r0        \n\t"
+            #endif
+            "pop  r0                  \n\t"
+            "out  __SREG__, r0        \n\t"
+            "pop  r0                  \n\t"
+            "ret                      \n\t"
+            #if defined(__AVR_3_BYTE_PC__)
+            :: [rampz] "I" (_SFR_IO_ADDR(RAMPZ)), [eind] "I" (_SFR_IO_ADDR(EIND))
+            #endif
+        );
+    }
+
+    // The entry point of every preemptive task activation. Runs the task on
+    // its own stack then switches to the highest priority remaining context.
+    static void trampoline() {
+        Context_t * context = &contexts[current];
+        Task_t * task = context->task;
+        // Run-to-completion tasks expect to find themselves here when resumed
+        Task_t * preempted = Registers::current_task;
+
+        sei();
+        bool again = Task::run(task);
+        cli();
+
+        // Only changed with interrupts disabled, a schedule in between must 
+        // still see this context running
+        Registers::current_task = preempted;
+        // Pools are not safe to touch here, the main loop reclaims it
+        context->state = again ? Context_Idle : Context_Dead;
+        schedule();
+        // Never reached, a finished context is not resumed
+    }
+
+    // Builds the initial stack frame of a context so that switch_context
+    // "returns" into the trampoline with cleared registers. Done every time
+    // the context goes from ready to running
+    static void prepare(Context_t * context) {
+        u8 * sp = context->stack + RTOS_PREEMPT_STACK - 1;
+        u16 address = (u16) (size_t) trampoline;
+        *sp-- = (u8) address;
+        *sp-- = (u8) (address >> 8);
+        #if defined(__AVR_3_BYTE_PC__)
+        *sp-- = 0;
+        #endif
+        for (u8 i = 0; i < CONTEXT_BYTES; i++) {
+            *sp-- = 0;
+        }
+        context->sp = sp;
+    }
+
+    // Returns true if the task of an idle context should be released
+    static inline bool released(Task_t * task, Time_t time) {
+        if (task->events) {
+            return task->impl.pending;
+        }
+        return (Time_Delta_t) (time - task->impl.next_release) >= 0;
+    }
+
+    void init() {
+        stack_pool = Memory::Pool::init(
+            "RTOS::Preempt::stack_pool",
+            RTOS_PREEMPT_STACK,
+            RTOS_PREEMPT_TASKS,
+            Memory::Pool_Bitmap
+        );
+        contexts[0].state = Context_Running;
+    }
+
+    bool add(Task_t * task) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            for (u8 i = 1; i <= RTOS_PREEMPT_TASKS; i++) {
+                Context_t * context = &contexts[i];
+                if (context->state == Context_Free) {
+                    task->impl.next_release = Task::time_next(task);
+                    context->task  = task;
+                    context->stack = (u8 *) Memory::Pool::alloc(stack_pool);
+                    context->state = Context_Idle;
+                    if (task->events) {
+                        Task::subscribe(task);
+                    }
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool requeue(Task_t * task, bool result) {
+        bool again = task->period_ms || task->delay_ms || task->events;
+        #ifdef RTOS_COROUTINE
+        again = again || task->impl.resume;
+        #endif
+        if (!result || !again) {
+            return false;
+        }
+        task->impl.next_release = Task::time_next(task);
+        return true;
+    }
+
+    #ifdef RTOS_ADMISSION
+    u8 periodic(Task_t ** set) {
+        u8 count = 0;
+        for (u8 i = 1; i <= RTOS_PREEMPT_TASKS; i++) {
+            Context_t * context = &contexts[i];
+            if (context->state != Context_Free && context->state != Context_Dead && context->task->period_ms > 0) {
+                set[count++] = context->task;
+            }
+        }
+        return count;
+    }
+    #endif
+
+    void reclaim() {
+        for (u8 i = 1; i <= RTOS_PREEMPT_TASKS; i++) {
+            Context_t * context = &contexts[i];
+            if (context->state == Context_Dead) {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    // Its events may have changed since it subscribed
+                    Task::unsubscribe(context->task);
+                    Memory::Pool::dealloc(stack_pool, context->stack);
+                    Memory::Pool::dealloc(Registers::task_pool, context->task);
+                    context->task  = nullptr;
+                    context->state = Context_Free;
+                }
+            }
+        }
+    }
+
+    void schedule() {
+
+        Time_t time = Time::now();
+        bool finished = contexts[current].state != Context_Running;
+
+        // The main context can always run, a finished context cannot
+        next = 0;
+        if (!finished) {
+            next = current;
+        }
+
+        for (u8 i = 1; i <= RTOS_PREEMPT_TASKS; i++) {
+            Context_t * context = &contexts[i];
+            if (context->state == Context_Idle && released(context->task, time)) {
+                context->state = Context_Ready;
+            }
+            // A finished context is still running on its own stack, it must 
+            // switch away and be prepared again before it runs
+            if (finished && i == current) {
+                continue;
+            }
+            if (
+                (context->state == Context_Ready || (context->state == Context_Running && i != current)) &&
+                priority(i) > priority(next)
+            ) {
+                next = i;
+            }
+        }
+
+        if (next != current) {
+            if (contexts[next].state == Context_Ready) {
+                prepare(&contexts[next]);
+                contexts[next].state = Context_Running;
+            }
+            switch_context();
+        }
+    }
+
+}}
+
+extern "C" void rtos_select_context() {
+    using namespace RTOS::Preempt;
+    contexts[current].sp = rtos_stack_pointer;
+    current = next;
+    rtos_stack_pointer = contexts[current].sp;
+}
+
+#endif
@@ -7,16 +7,19 @@ namespace RTOS {
 
         // Public registers
         Event_t triggers;
-        volatile Event_t events;
         volatile Trace_t trace;
 
         // Private registers        
         Memory::Pool_t * task_pool;
         Task_t * current_task;
-        Task_t * periodic_tasks;
+        Task_Heap_t periodic_tasks;
         Task_t * delayed_tasks;
-        Task_t * event_tasks;
-        Task_t * event_tasks_tail;
+        #ifdef RTOS_EDF
+        Task_Heap_t ready_tasks;
+        #endif
+        static_dispatch_t static_tasks;
+        Task_List_t event_tasks;
+        Event_Queue_t event_queue;
 
     }
 
@@ -26,18 +29,81 @@ namespace RTOS {
 
         MAIN_LOOP: for (;;) {
  
-            i64 this_time = Time::now();
-            i64 idle_time = 0xFFFF;
+            #ifdef RTOS_PREEMPT
+            Preempt::reclaim();
+            #endif
+
+            // Wake the consumers of rings pushed to from interrupts
+            Event::Ring::collect();
+
+            Time_t this_time = Time::now();
+            Time_Delta_t idle_time = 0xFFFF;
 
             Task_t * task;
 
-            task = Registers::periodic_tasks;
+            // Static tasks come first, a frame is run each time round
+            if (Registers::static_tasks != nullptr) {
+                Time_Delta_t time_remaining = Registers::static_tasks(this_time);
+                if (time_remaining <= 0) {
+                    goto MAIN_LOOP;
+                }
+                idle_time = min(idle_time, time_remaining);
+            }
+
+            #ifdef RTOS_EDF
+            // Move every released task into the ready heap
+            while ((task = Task::heap_peek(&Registers::periodic_tasks)) != nullptr) {
+                Time_Delta_t time_remaining = Task::time_remaining(task, this_time);
+                if (time_remaining > 0) {
+                    idle_time = min(idle_time, time_remaining);
+                    break;
+                }
+                Task::heap_pop(&Registers::periodic_tasks);
+                Task::release(task);
+            }
+            while ((task = Registers::delayed_tasks) != nullptr) {
+                Time_Delta_t time_remaining = Task::time_remaining(task, this_time);
+                if (time_remaining > 0) {
+                    idle_time = min(idle_time, time_remaining);
+                    break;
+                }
+                Registers::delayed_tasks = Task::cdr(task);
+                Task::release(task);
+            }
+            while ((task = Event::next()) != nullptr) {
+                #ifdef RTOS_SERVER
+                Time_Delta_t time_remaining = Server::wait(this_time);
+                if (time_remaining > 0) {
+                    idle_time = min(idle_time, time_remaining);
+                    break;
+                }
+                #endif
+                Event::pop();
+                if (!task->impl.ready) {
+                    Task::release(task);
+                    #ifdef RTOS_SERVER
+                    // One at a time, so each is charged before the next
+                    break;
+                    #endif
+                }
+            }
+
+            // Run the task with the earliest deadline
+            task = Task::heap_peek(&Registers::ready_tasks);
+            if (task != nullptr) {
+                Task::heap_pop(&Registers::ready_tasks);
+                task->impl.ready = false;
+                Task::run(task);
+                goto MAIN_LOOP;
+            }
+            #else
+            task = Task::heap_peek(&Registers::periodic_tasks);
             if (task != nullptr) {
-                i64 time_remaining = Task::time_remaining(task, this_time);
+                Time_Delta_t time_remaining = Task::time_remaining(task, this_time);
                 if (time_remaining <= 0) {
-                    // We need to pop the task off the list before running the task
+                    // We need to pop the task off the heap before running the task
                     // Run will handle re-inserting it correctly
-                    Registers::periodic_tasks = Task::cdr(task);
+                    Task::heap_pop(&Registers::periodic_tasks);
                     Task::run(task);
                     goto MAIN_LOOP;
                 } else {
@@ -47,7 +113,7 @@ namespace RTOS {
 
             task = Registers::delayed_tasks;
             if (task != nullptr) {
-                i64 time_remaining = Task::time_remaining(task, this_time);
+                Time_Delta_t time_remaining = Task::time_remaining(task, this_time);
                 if (time_remaining <= 0) {
                     if (Task::fits(task, idle_time)) {
                         // We need to pop the task off the list before running 
@@ -60,18 +126,25 @@ namespace RTOS {
                     idle_time = min(idle_time, time_remaining);
                 }
             }
-            task = Registers::event_tasks;
-            if (Registers::events) {
-                while (task != nullptr) {
-                    if (task->events & Registers::events) {
-                        if (Task::fits(task, idle_time)) {
-                            Task::run(task);
-                        }
-                        goto MAIN_LOOP;
-                    }
-                    task = Task::cdr(task);
+            task = Event::next();
+            #ifdef RTOS_SERVER
+            // Event tasks wait while the server has no budget left
+            if (task != nullptr) {
+                Time_Delta_t time_remaining = Server::wait(this_time);
+                if (time_remaining > 0) {
+                    idle_time = min(idle_time, time_remaining);
+                    task = nullptr;
                 }
             }
+            #endif
+            if (task != nullptr) {
+                if (Task::fits(task, idle_time)) {
+                    Event::pop();
+                    Task::run(task);
+                }
+                goto MAIN_LOOP;
+            }
+            #endif
             Time::idle(this_time, idle_time);
         }
     }
@@ -85,8 +158,18 @@ namespace RTOS {
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Init;
-            Registers::trace.mark.init.time = Time::now();
+            Registers::trace.mark.init.time = Time::stamp();
             Registers::trace.mark.init.heap = RTOS_VIRTUAL_HEAP;
+            #ifdef RTOS_TIME_US
+            Registers::trace.mark.init.resolution = 1;
+            #else
+            Registers::trace.mark.init.resolution = 1000;
+            #endif
+            #ifdef RTOS_LATCH
+            Registers::trace.mark.init.latency = true;
+            #else
+            Registers::trace.mark.init.latency = false;
+            #endif
             trace();
         }
         #endif
@@ -94,8 +177,43 @@ namespace RTOS {
         Registers::task_pool = Memory::Pool::init(
             "RTOS::Registers::task_pool", 
             sizeof(Task_t), 
-            RTOS_MAX_TASKS
+            RTOS_MAX_TASKS,
+            Memory::Pool_Grow
+        );
+
+        Registers::periodic_tasks.data = (Task_t **) Memory::static_alloc(
+            "RTOS::Registers::periodic_tasks",
+            sizeof(Task_t *) * RTOS_MAX_TASKS
+        );
+
+        Registers::event_tasks.data = (Task_t **) Memory::static_alloc(
+            "RTOS::Registers::event_tasks",
+            sizeof(Task_t *) * RTOS_MAX_TASKS
+        );
+
+        #ifdef RTOS_EDF
+        Registers::ready_tasks.by_deadline = true;
+        Registers::ready_tasks.data = (Task_t **) Memory::static_alloc(
+            "RTOS::Registers::ready_tasks",
+            sizeof(Task_t *) * RTOS_MAX_TASKS
         );
+        #endif
+
+        #ifdef RTOS_HEAP
+        Memory::Heap::init();
+        #endif
+
+        #ifdef RTOS_SCRATCH
+        Memory::Scratch::init();
+        #endif
+
+        #ifdef RTOS_PREEMPT
+        Preempt::init();
+        #endif
+
+        #ifdef RTOS_STACK_PAINT
+        Memory::Stack::paint();
+        #endif
     }
 
     void halt() {
@@ -103,7 +221,7 @@ namespace RTOS {
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Halt;
-            Registers::trace.mark.halt.time = Time::now();
+            Registers::trace.mark.halt.time = Time::stamp();
             trace();
         }
         #endif 
@@ -115,6 +233,14 @@ namespace RTOS {
         exit(0);
     }
 
+    namespace Static {
+
+        void attach(static_dispatch_t dispatch) {
+            Registers::static_tasks = dispatch;
+        }
+
+    }
+
     void trace() {
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -0,0 +1,66 @@
+#include <RTOS.h>
+#include <Private.h>
+
+#ifdef RTOS_SERVER
+
+namespace RTOS {
+namespace Server {
+
+    // The budget left in the current period (us), negative once overrun
+    static i32 budget_us = RTOS_SERVER_BUDGET_US;
+
+    // When the budget is next replenished
+    static Time_t replenish = RTOS_SERVER_PERIOD_MS;
+
+    // Set once the budget has run out in the current period
+    static volatile bool exhausted = false;
+
+    // Replenishes the budget if a period boundary has passed by `time`
+    static void update(Time_t time) {
+        Time_Delta_t late = (Time_Delta_t) (time - replenish);
+        if (late < 0) {
+            return;
+        }
+        Time_Delta_t periods = late / RTOS_SERVER_PERIOD_MS + 1;
+        replenish += periods * RTOS_SERVER_PERIOD_MS;
+        // Every elapsed period adds one budget, so an overrun is paid back
+        // from as many budgets as it took. Compared first, so a long idle 
+        // time cannot overflow the sum
+        if (periods > (RTOS_SERVER_BUDGET_US - budget_us) / RTOS_SERVER_BUDGET_US) {
+            budget_us = RTOS_SERVER_BUDGET_US;
+        } else {
+            budget_us += (i32) periods * RTOS_SERVER_BUDGET_US;
+        }
+        exhausted = false;
+    }
+
+    Time_Delta_t wait(Time_t time) {
+        update(time);
+        if (budget_us > 0) {
+            return 0;
+        }
+        if (!exhausted) {
+            exhausted = true;
+            #ifdef RTOS_TRACE
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Mark_Exhausted;
+                Registers::trace.mark.exhausted.time = Time::stamp();
+                Registers::trace.mark.exhausted.debt = (u16) min(-budget_us, (i32) 0xFFFF);
+                trace();
+            }
+            #endif
+        }
+        return (Time_Delta_t) (replenish - time);
+    }
+
+    void charge(Time_Delta_t elapsed_us) {
+        budget_us -= (i32) elapsed_us;
+    }
+
+    bool depleted() {
+        return exhausted;
+    }
+
+}}
+
+#endif
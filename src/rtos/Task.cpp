@@ -6,21 +6,60 @@ namespace Task {
 
     static u8 instance_count = 0;
 
-    #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
-        static Event_t taken_events = 0;
+    #ifdef RTOS_FIT_PERCENTILE
+    // Runtimes are bucketed in units of 2^HISTOGRAM_SHIFT stamps
+    #ifdef RTOS_TIME_US
+        #define HISTOGRAM_SHIFT 6
+    #else
+        #define HISTOGRAM_SHIFT 0
+    #endif
     #endif
 
     Task_t * init(const char * handle, task_fn_t fn) {
         Task_t * task = (Task_t *) Memory::Pool::alloc(Registers::task_pool);
-        task->fn            = fn;
-        task->state         = nullptr;
-        task->events        = 0;
-        task->period_ms     = 0;
-        task->delay_ms      = 0;
-        task->impl.first    = true;
-        task->impl.last     = 0;
-        task->impl.maximum  = 0;
-        task->impl.instance = instance_count++;
+        task->fn                = fn;
+        task->state             = nullptr;
+        task->events            = 0;
+        task->period_ms         = 0;
+        task->delay_ms          = 0;
+        #ifdef RTOS_PREEMPT
+        task->priority          = 0;
+        #endif
+        #if defined(RTOS_EDF) || defined(RTOS_ADMISSION)
+        task->deadline_ms       = 0;
+        #endif
+        #ifdef RTOS_ADMISSION
+        task->wcet_us           = 0;
+        #endif
+        #ifdef RTOS_BUDGET
+        task->budget_us         = 0;
+        #endif
+        task->impl.first        = true;
+        task->impl.last         = 0;
+        task->impl.next_release = 0;
+        task->impl.pending      = 0;
+        task->impl.slot         = TASK_UNSUBSCRIBED;
+        task->impl.maximum      = 0;
+        task->impl.instance     = instance_count++;
+        task->impl.order        = 0;
+        #ifdef RTOS_COROUTINE
+        task->impl.resume       = 0;
+        #endif
+        #ifdef RTOS_FIT_PERCENTILE
+        for (u8 i = 0; i < TASK_HISTOGRAM_BUCKETS; i++) {
+            task->impl.histogram[i] = 0;
+        }
+        #endif
+        #ifdef RTOS_EDF
+        task->impl.deadline     = 0;
+        task->impl.ready        = false;
+        #endif
+        #ifdef RTOS_SCRATCH
+        task->impl.scratch      = 0;
+        #endif
+        #ifdef RTOS_BUDGET
+        task->impl.overruns     = 0;
+        #endif
 
         if (Registers::current_task != nullptr) {
             task->impl.last = Registers::current_task->impl.last;
@@ -75,29 +114,91 @@ namespace Task {
                 error();
             }
         }
-        if (task->events & taken_events) {
-            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-                Registers::trace.tag = Error_Duplicate_Event;
-                Registers::trace.error.duplicate_event.event = task->events & taken_events;
-                error();
+        #endif
+
+        #ifdef RTOS_ADMISSION
+        if (task->period_ms > 0 && !Task::admit(task)) {
+            return;
+        }
+        #endif
+
+        #ifdef RTOS_PREEMPT
+        if (task->priority) {
+            if (!Preempt::add(task)) {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    Registers::trace.tag = Error_Max_Task;
+                    error();
+                }
+                Memory::Pool::dealloc(Registers::task_pool, task);
             }
+            return;
         }
-        taken_events |= task->events;
         #endif
 
         if (task->period_ms > 0) {
-            Registers::periodic_tasks = Task::insert_ordered(Registers::periodic_tasks, task);
+            Task::heap_push(&Registers::periodic_tasks, task);
         } else if (task->delay_ms > 0 || !task->events) {
             Registers::delayed_tasks = Task::insert_ordered(Registers::delayed_tasks, task);
         } else {
-            Registers::event_tasks_tail = Task::insert_tail(Registers::event_tasks_tail, task);
-            if (Registers::event_tasks == nullptr) {
-                Registers::event_tasks = Registers::event_tasks_tail;
+            Task::subscribe(task);
+        }
+    }
+
+    #ifdef RTOS_FIT_PERCENTILE
+    // Returns the histogram bucket of a runtime
+    static u8 bucket(Time_Delta_t runtime) {
+        u32 units = (u32) runtime >> HISTOGRAM_SHIFT;
+        u8 i = 0;
+        while (units && i < TASK_HISTOGRAM_BUCKETS - 1) {
+            units >>= 1;
+            i++;
+        }
+        return i;
+    }
+
+    // Counts a run of `task`, halving every count first if it would overflow
+    static void record(Task_t * task, Time_Delta_t runtime) {
+        u8 * histogram = task->impl.histogram;
+        u8 i = bucket(runtime);
+        if (histogram[i] == 0xFF) {
+            for (u8 j = 0; j < TASK_HISTOGRAM_BUCKETS; j++) {
+                histogram[j] >>= 1;
             }
         }
+        histogram[i]++;
     }
 
-    void run(Task_t * task) {
+    // Returns the RTOS_FIT_PERCENTILE runtime of `task`, the longest runtime
+    // of the bucket it falls in or the maximum runtime for the last bucket
+    static Time_Delta_t estimate(Task_t * task) {
+        u8 * histogram = task->impl.histogram;
+        u16 total = 0;
+        for (u8 i = 0; i < TASK_HISTOGRAM_BUCKETS; i++) {
+            total += histogram[i];
+        }
+        u16 target = ((u32) total * RTOS_FIT_PERCENTILE + 99) / 100;
+        u16 count = 0;
+        for (u8 i = 0; i < TASK_HISTOGRAM_BUCKETS - 1; i++) {
+            count += histogram[i];
+            if (count >= target) {
+                return ((Time_Delta_t) 1 << i << HISTOGRAM_SHIFT) - 1;
+            }
+        }
+        return task->impl.maximum;
+    }
+    #endif
+
+    #if defined(RTOS_TRACE) && defined(RTOS_LATCH)
+    // Returns how long after its release `task` is starting in microseconds.
+    // Releases fall on the millisecond tick, so the release is exact
+    static u16 latency(Task_t * task) {
+        Time_t release = task->impl.next_release * 1000;
+        Time_Delta_t delta = (Time_Delta_t) (Time::now_us() - release);
+        return delta > 0 ? (u16) min(delta, (Time_Delta_t) 0xFFFF) : 0;
+    }
+    #endif
+
+    bool run(Task_t * task) {
 
         #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
         if (task == nullptr) {
@@ -110,16 +211,24 @@ namespace Task {
 
         Event_t save = task->events;
 
-        // Atomically update events
+        // Atomically take the events dispatched to this task
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-            Registers::triggers |= (Registers::events & save);
-            Registers::events = (Registers::events & ~save);
+            Registers::triggers |= task->impl.pending;
+            task->impl.pending = 0;
         }
 
-        i64 now = Task::time_next(task);
+        #ifdef RTOS_COROUTINE
+        // A yielded coroutine is not due at any particular time
+        bool yielded = !save && task->impl.resume && !task->period_ms && !task->delay_ms;
+        #else
+        bool yielded = false;
+        #endif
+
+        // Queued tasks already know when they were due
+        Time_t now = (save || yielded) ? Time::now() : task->impl.next_release;
 
         // Check for miss
-        if (!save && Time::now() > now) {
+        if (!save && !yielded && (Time_Delta_t) (Time::now() - now) > 0) {
             ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
                 Registers::trace.tag = Error_Missed;
                 Registers::trace.error.missed.instance = task->impl.instance;
@@ -136,20 +245,74 @@ namespace Task {
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Start;
-            Registers::trace.mark.start.time = Time::now();
+            Registers::trace.mark.start.time = Time::stamp();
             Registers::trace.mark.start.instance = task->impl.instance;
+            #ifdef RTOS_LATCH
+            // Event tasks are not released at a known time
+            Registers::trace.mark.start.latency = save ? 0 : latency(task);
+            #endif
             trace();
         }
         #endif
 
+        #ifdef RTOS_SERVER
+        // Event tasks draw their runtime from the server
+        bool served = save;
+        #ifdef RTOS_PREEMPT
+        served = served && !task->priority;
+        #endif
+        Time_t served_start = served ? Time::now_us() : 0;
+        #endif
+
+        #ifdef RTOS_SCRATCH
+        // Everything the task takes from scratch is released when it returns
+        u16 scratch = Memory::Scratch::mark();
+        #endif
+
         // Run task
+        Time_t start = Time::stamp();
+        #ifdef RTOS_BUDGET
+        if (task->budget_us) {
+            Time::arm_budget(task->budget_us);
+        }
+        #endif
         bool result = task->fn(task);
+        #ifdef RTOS_BUDGET
+        if (task->budget_us) {
+            Time::disarm_budget();
+        }
+        #endif
+        Time_Delta_t runtime = (Time_Delta_t) (Time::stamp() - start);
+        #ifdef RTOS_SCRATCH
+        task->impl.scratch = max(task->impl.scratch, (u16) (Memory::Scratch::mark() - scratch));
+        Memory::Scratch::rewind(scratch);
+        #endif
+        #ifdef RTOS_SERVER
+        if (served) {
+            Server::charge((Time_Delta_t) (Time::now_us() - served_start));
+        }
+        #endif
+
+        #ifdef RTOS_EDF
+        if ((Time_Delta_t) (Time::now() - task->impl.deadline) > 0) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Deadline;
+                Registers::trace.error.deadline.instance = task->impl.instance;
+                error();
+            }
+        }
+        #endif
 
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Stop;
-            Registers::trace.mark.stop.time = Time::now();
+            Registers::trace.mark.stop.time = Time::stamp();
             Registers::trace.mark.stop.instance = task->impl.instance;
+            #ifdef RTOS_SCRATCH
+            Registers::trace.mark.stop.scratch = task->impl.scratch;
+            #else
+            Registers::trace.mark.stop.scratch = 0;
+            #endif
             trace();
         }
         #endif
@@ -167,60 +330,48 @@ namespace Task {
         #endif
 
         // Update fields
-        task->impl.maximum = max(task->impl.maximum, Time::now() - now);
+        task->impl.maximum = max(task->impl.maximum, runtime);
         task->impl.first = false;
+        #ifdef RTOS_FIT_PERCENTILE
+        record(task, runtime);
+        #endif
 
-        if (save) {
-            if (!task->events || !result) {
-                #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
-                taken_events &= ~task->events;
-                #endif
-
-                // Remove task from event_tasks
-                if (Registers::event_tasks == task) {
-                    Registers::event_tasks = Task::cdr(task);
-                } else {
-                    Task_t * event_tasks = Registers::event_tasks;
-                    while (event_tasks) {
-                        if (Task::cdr(event_tasks) == task) {
-                            Memory::Pool::cons(event_tasks, Task::cdr(event_tasks));
-                        }
-                        event_tasks = Task::cdr(event_tasks);
-                    }
-                }
-            }
-
+        #ifdef RTOS_PREEMPT
+        if (task->priority) {
+            return Preempt::requeue(task, result);
         }
+        #endif
 
-        #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
-        if (task->events & ~save & taken_events) {
-            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-                Registers::trace.tag = Error_Duplicate_Event;
-                Registers::trace.error.duplicate_event.event = task->events & taken_events;
-                error();
-            }
+        // A task that changed its events stays subscribed, the new events are
+        // matched from the next dispatch on
+        if (save && (!task->events || !result)) {
+            Task::unsubscribe(task);
         }
-        taken_events |= task->events;
-        #endif
+
         if (!result) {
             Memory::Pool::dealloc(Registers::task_pool, task);       
+            return false;
         } else if (task->events && save) {
-            return;         
+            return true;
         } else if (task->period_ms) {
-            Registers::periodic_tasks = Task::insert_ordered(Registers::periodic_tasks, task);
+            Task::heap_push(&Registers::periodic_tasks, task);
         } else if (task->delay_ms) {
             Registers::delayed_tasks = Task::insert_ordered(Registers::delayed_tasks, task);
         } else if (task->events) {
-            Registers::event_tasks_tail = Task::insert_tail(Registers::event_tasks_tail, task);
-            if (Registers::event_tasks == nullptr) {
-                Registers::event_tasks = Registers::event_tasks_tail;
-            }
+            Task::subscribe(task);
+        #ifdef RTOS_COROUTINE
+        } else if (task->impl.resume) {
+            // A yielded coroutine runs again as soon as possible
+            Registers::delayed_tasks = Task::insert_ordered(Registers::delayed_tasks, task);
+        #endif
         } else {
             Memory::Pool::dealloc(Registers::task_pool, task);
+            return false;
         }
+        return true;
     }
 
-    bool fits(Task_t * task, i64 time) {
+    bool fits(Task_t * task, Time_Delta_t time) {
 
         #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
         if (task == nullptr) {
@@ -231,19 +382,92 @@ namespace Task {
         }
         #endif
 
-        return task->impl.maximum < time;
+        #ifdef RTOS_FIT_PERCENTILE
+        Time_Delta_t runtime = estimate(task);
+        #else
+        Time_Delta_t runtime = task->impl.maximum;
+        #endif
+
+        #ifdef RTOS_TIME_US
+        return runtime < time * 1000;
+        #else
+        return runtime < time;
+        #endif
+    }
+
+    void trace_histogram(Task_t * task) {
+        #if defined(RTOS_FIT_PERCENTILE) && defined(RTOS_TRACE)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            Registers::trace.tag = Mark_Histogram;
+            Registers::trace.mark.histogram.time = Time::stamp();
+            Registers::trace.mark.histogram.instance = task->impl.instance;
+            for (u8 i = 0; i < TASK_HISTOGRAM_BUCKETS; i++) {
+                Registers::trace.mark.histogram.buckets[i] = task->impl.histogram[i];
+            }
+            trace();
+        }
+        #endif
     }
 
     Task_t * cdr(Task_t * tasks) {
         return (Task_t *) Memory::Pool::cdr(tasks);
     }
 
-    Task_t * insert_tail(Task_t * tasks_tail, Task_t * task) {
-        Memory::Pool::cons(task, nullptr);
-        if (tasks_tail != nullptr) {
-            Memory::Pool::cons(tasks_tail, task);
+    void subscribe(Task_t * task) {
+        Task_List_t * tasks = &Registers::event_tasks;
+
+        #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
+        if (tasks->size >= RTOS_MAX_TASKS) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Max_Task;
+                error();
+            }
+            return;
+        }
+        #endif
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            task->impl.slot = tasks->size;
+            tasks->data[tasks->size++] = task;
+            Event::claim(task);
+        }
+    }
+
+    void unsubscribe(Task_t * task) {
+        Task_List_t * tasks = &Registers::event_tasks;
+        Event_Queue_t * queue = &Registers::event_queue;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            u8 slot = task->impl.slot;
+            if (slot != TASK_UNSUBSCRIBED) {
+                // Move the last task into the freed slot
+                Task_t * last = tasks->data[--tasks->size];
+                tasks->data[slot] = last;
+                last->impl.slot = slot;
+                task->impl.slot = TASK_UNSUBSCRIBED;
+            }
+            if (!task->impl.pending) {
+                return;
+            }
+            // An event arrived while the task was running, so it was queued
+            // again. Rare, so the queue is searched
+            task->impl.pending = 0;
+            Task_t * previous = nullptr;
+            for (Task_t * current = queue->head; current != nullptr; current = Task::cdr(current)) {
+                if (current == task) {
+                    Task_t * cdr = Task::cdr(current);
+                    if (previous == nullptr) {
+                        queue->head = cdr;
+                    } else {
+                        Memory::Pool::cons(previous, cdr);
+                    }
+                    if (queue->tail == task) {
+                        queue->tail = previous;
+                    }
+                    break;
+                }
+                previous = current;
+            }
         }
-        return task;
     }
 
     Task_t * insert_ordered(Task_t * tasks, Task_t * task) {
@@ -257,16 +481,17 @@ namespace Task {
         }
         #endif
 
-        i64 time_next = Task::time_next(task);
+        Time_t time_next = Task::time_next(task);
+        task->impl.next_release = time_next;
 
-        if (tasks == nullptr || Task::time_next(tasks) > time_next) {
+        if (tasks == nullptr || (Time_Delta_t) (tasks->impl.next_release - time_next) > 0) {
             Memory::Pool::cons(task, tasks);
             return task;
         } else {
             Task_t * current = tasks;
             for (;;) {
                 Task_t * cdr = Task::cdr(current);
-                if (cdr == nullptr || Task::time_next(cdr) > time_next) {
+                if (cdr == nullptr || (Time_Delta_t) (cdr->impl.next_release - time_next) > 0) {
                     Memory::Pool::cons(current, task);
                     Memory::Pool::cons(task, cdr);
                     break;
@@ -277,7 +502,293 @@ namespace Task {
         return tasks;
     }
 
-    i64 time_next(Task_t * task) {
+    // Returns true if task `a` should be run before task `b`
+    static bool heap_before(Task_Heap_t * heap, Task_t * a, Task_t * b) {
+        #ifdef RTOS_EDF
+        Time_Delta_t delta = heap->by_deadline
+            ? (Time_Delta_t) (a->impl.deadline - b->impl.deadline)
+            : (Time_Delta_t) (a->impl.next_release - b->impl.next_release);
+        #else
+        Time_Delta_t delta = (Time_Delta_t) (a->impl.next_release - b->impl.next_release);
+        #endif
+        if (delta != 0) {
+            return delta < 0;
+        }
+        // Wraparound safe unless a task waits through 2^15 other insertions,
+        // which only swaps the order of tasks due at the same time
+        return (i16) (a->impl.order - b->impl.order) < 0;
+    }
+
+    Task_t * heap_peek(Task_Heap_t * heap) {
+        if (heap->size == 0) {
+            return nullptr;
+        }
+        return heap->data[0];
+    }
+
+    Task_t * heap_pop(Task_Heap_t * heap) {
+
+        Task_t ** data = heap->data;
+        Task_t * top   = data[0];
+        Task_t * last  = data[--heap->size];
+
+        // Sift the last task down from the root
+        u8 i = 0;
+        for (;;) {
+            u8 child = 2 * i + 1;
+            if (child >= heap->size) {
+                break;
+            }
+            if (child + 1 < heap->size && heap_before(heap, data[child + 1], data[child])) {
+                child++;
+            }
+            if (!heap_before(heap, data[child], last)) {
+                break;
+            }
+            data[i] = data[child];
+            i = child;
+        }
+        data[i] = last;
+
+        return top;
+    }
+
+    void heap_push(Task_Heap_t * heap, Task_t * task) {
+
+        #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
+        if (task == nullptr) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Null_Task;
+                error();
+            }
+        }
+        #endif
+
+        Task_t ** data = heap->data;
+        if (!heap->by_deadline) {
+            task->impl.next_release = Task::time_next(task);
+        }
+        task->impl.order = heap->order++;
+
+        // Sift the new task up from the bottom
+        u8 i = heap->size++;
+        while (i > 0) {
+            u8 parent = (i - 1) / 2;
+            if (!heap_before(heap, task, data[parent])) {
+                break;
+            }
+            data[i] = data[parent];
+            i = parent;
+        }
+        data[i] = task;
+    }
+
+    #ifdef RTOS_ADMISSION
+    // Liu-Layland bound n(2^(1/n) - 1) in per mille, rounded down. Larger 
+    // task sets use ln(2)
+    static const u16 utilization_bound[] = {1000, 828, 779, 756, 743, 734, 728, 724};
+    #define UTILIZATION_BOUNDS (sizeof(utilization_bound) / sizeof(u16))
+    #define UTILIZATION_LIMIT  693
+
+    // Collects the periodic tasks already dispatched into `set` and returns 
+    // how many there are. The running task is not queued while it runs, but
+    // will be again afterwards
+    static u8 admitted(Task_t * task, Task_t ** set) {
+        u8 count = 0;
+        Task_Heap_t * heap = &Registers::periodic_tasks;
+        for (u8 i = 0; i < heap->size; i++) {
+            set[count++] = heap->data[i];
+        }
+        #ifdef RTOS_EDF
+        // Released tasks wait in the ready heap until they run
+        heap = &Registers::ready_tasks;
+        for (u8 i = 0; i < heap->size; i++) {
+            if (heap->data[i]->period_ms > 0) {
+                set[count++] = heap->data[i];
+            }
+        }
+        #endif
+        #ifdef RTOS_PREEMPT
+        count += Preempt::periodic(set + count);
+        #endif
+        Task_t * current = Registers::current_task;
+        if (current == nullptr || current == task || current->period_ms <= 0) {
+            return count;
+        }
+        // The running task may also have been queued again already
+        for (u8 i = 0; i < count; i++) {
+            if (set[i] == current) {
+                return count;
+            }
+        }
+        set[count++] = current;
+        return count;
+    }
+
+    // Returns the worst case execution time of a task in us
+    static u32 wcet(Task_t * task) {
+        if (task->wcet_us) {
+            return task->wcet_us;
+        }
+        #ifdef RTOS_TIME_US
+        return task->impl.maximum;
+        #else
+        return (u32) task->impl.maximum * 1000;
+        #endif
+    }
+
+    // Returns the utilization of a task in parts per million, rounded up
+    static u32 utilization(Task_t * task) {
+        return (wcet(task) * 1000 + task->period_ms - 1) / task->period_ms;
+    }
+
+    // Returns the relative deadline of a task in us, its period unless 
+    // `deadline_ms` is shorter
+    static u32 deadline_us(Task_t * task) {
+        if (task->deadline_ms > 0 && task->deadline_ms < task->period_ms) {
+            return (u32) task->deadline_ms * 1000;
+        }
+        return (u32) task->period_ms * 1000;
+    }
+
+    // Returns true if task `a` has a higher priority than `b`. Preemptive 
+    // tasks come first by priority, then tasks in rate monotonic order
+    static inline bool higher_priority(Task_t * a, Task_t * b) {
+        #ifdef RTOS_PREEMPT
+        if (a->priority != b->priority) {
+            return a->priority > b->priority;
+        }
+        #endif
+        if (a->period_ms != b->period_ms) {
+            return a->period_ms < b->period_ms;
+        }
+        return a->impl.instance < b->impl.instance;
+    }
+
+    // Returns the longest `task` can wait for a lower priority task that 
+    // already started, as run-to-completion tasks cannot be preempted (us)
+    static u32 blocking(Task_t * task, Task_t ** set, u8 count) {
+        #ifdef RTOS_PREEMPT
+        // Preemptive tasks do not wait for anything to complete
+        if (task->priority) {
+            return 0;
+        }
+        #endif
+        u32 longest = 0;
+        for (u8 i = 0; i < count; i++) {
+            if (set[i] != task && higher_priority(task, set[i])) {
+                longest = max(longest, wcet(set[i]));
+            }
+        }
+        return longest;
+    }
+
+    // Returns true if the worst case response time of `task` meets its 
+    // deadline, blocked by one lower priority task and interfered with by 
+    // every higher priority task in the set
+    static bool response_time(Task_t * task, Task_t ** set, u8 count) {
+        u32 deadline = deadline_us(task);
+        u32 response = wcet(task) + blocking(task, set, count);
+        u32 last = 0;
+        while (response != last) {
+            if (response > deadline) {
+                return false;
+            }
+            last = response;
+            response = wcet(task) + blocking(task, set, count);
+            for (u8 i = 0; i < count; i++) {
+                Task_t * other = set[i];
+                if (other != task && higher_priority(other, task)) {
+                    u32 period = (u32) other->period_ms * 1000;
+                    response += ((last + period - 1) / period) * wcet(other);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool admit(Task_t * task) {
+        Time_t start = Time::now_us();
+        Task_t * set[RTOS_MAX_TASKS];
+        u8 count = admitted(task, set);
+        set[count++] = task;
+        u8 result = Admission_Rejected;
+
+        // The bound only holds for deadlines equal to the periods, blocking
+        // is added as the utilization of the worst blocked task
+        u32 total = 0;
+        u32 blocked = 0;
+        bool constrained = false;
+        for (u8 i = 0; i < count; i++) {
+            Task_t * member = set[i];
+            u32 period = (u32) member->period_ms * 1000;
+            total += utilization(member);
+            blocked = max(blocked, (blocking(member, set, count) * 1000 + member->period_ms - 1) / member->period_ms);
+            constrained = constrained || deadline_us(member) < period;
+        }
+
+        u16 bound = count <= UTILIZATION_BOUNDS ? utilization_bound[count - 1] : UTILIZATION_LIMIT;
+        if (!constrained && total + blocked <= (u32) bound * 1000) {
+            result = Admission_Bound;
+        } else if (total <= 1000000) {
+            result = Admission_Exact;
+            for (u8 i = 0; i < count && result == Admission_Exact; i++) {
+                if (!response_time(set[i], set, count)) {
+                    result = Admission_Rejected;
+                }
+            }
+        }
+
+        u16 cost = (u16) (Time::now_us() - start);
+        u16 per_mille = (u16) min(total / 1000, (u32) 0xFFFF);
+
+        #ifdef RTOS_TRACE
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            Registers::trace.tag = Mark_Admit;
+            Registers::trace.mark.admit.time        = Time::stamp();
+            Registers::trace.mark.admit.instance    = task->impl.instance;
+            Registers::trace.mark.admit.result      = result;
+            Registers::trace.mark.admit.utilization = per_mille;
+            Registers::trace.mark.admit.cost        = cost;
+            trace();
+        }
+        #endif
+
+        if (result == Admission_Rejected) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                Registers::trace.tag = Error_Overload;
+                Registers::trace.error.overload.instance    = task->impl.instance;
+                Registers::trace.error.overload.utilization = per_mille;
+                error();
+            }
+            return false;
+        }
+        return true;
+    }
+    #endif
+
+    #ifdef RTOS_EDF
+    Time_Delta_t deadline(Task_t * task) {
+        if (task->deadline_ms) {
+            return task->deadline_ms;
+        }
+        if (task->period_ms) {
+            return task->period_ms;
+        }
+        // No deadline, run after every task that has one
+        return 0x7FFF;
+    }
+
+    void release(Task_t * task) {
+        if (!task->events) {
+            task->impl.deadline = task->impl.next_release + Task::deadline(task);
+        }
+        task->impl.ready = true;
+        Task::heap_push(&Registers::ready_tasks, task);
+    }
+    #endif
+
+    Time_t time_next(Task_t * task) {
 
         #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
         if (task == nullptr) {
@@ -293,13 +804,27 @@ namespace Task {
         }
 
         if (task->impl.first) {
+            #ifdef RTOS_TIME_32
+            // The first release counts from boot, which only the 64 bit time
+            // can still tell is past once the clock has wrapped
+            if (Time::now64() >= (i64) task->delay_ms) {
+                return Time::now();
+            }
+            #endif
             return task->delay_ms;
         }
 
+        #ifdef RTOS_COROUTINE
+        // A yielded coroutine is due again straight away
+        if (task->impl.resume && !task->period_ms && !task->delay_ms) {
+            return Time::now();
+        }
+        #endif
+
         return task->impl.last + task->period_ms + task->delay_ms;
     }
 
-    i64 time_remaining(Task_t * task, i64 time_ms) {
+    Time_Delta_t time_remaining(Task_t * task, Time_t time_ms) {
 
         #if defined(RTOS_CHECK_ALL) || defined(RTOS_CHECK_TASK)
         if (task == nullptr) {
@@ -310,7 +835,7 @@ namespace Task {
         }
         #endif
 
-        return Task::time_next(task) - time_ms;
+        return (Time_Delta_t) (task->impl.next_release - time_ms);
     }
 
 }}
\ No newline at end of file
@@ -2,15 +2,153 @@
 #include <Private.h>
 
 #define TIMER_COUNT 250
+// Microseconds per timer1 count (16 MHz scaled by 64)
+#define TIMER_US 4
+
+#ifdef RTOS_TICKLESS
+// The longest time in ms a single timer1 compare period can cover
+#define TICKLESS_MAX_MS (0xFFFF / (TIMER_COUNT + 1))
+#endif
+
+#ifdef RTOS_DEEP_SLEEP
+// Wakeup latency of each deep sleep mode in ms (16K CK oscillator start up
+// plus timer synchronization)
+#define POWER_SAVE_LATENCY_MS 1
+#define POWER_DOWN_LATENCY_MS 2
+// The 16K CK oscillator start up after a deep sleep in ms (16 MHz), the clock
+// is charged for it on every wakeup
+#define STARTUP_MS 1
+// Timer2 runs from a 32.768 kHz crystal scaled by 128, 256 ticks a second
+#define TIMER2_MAX_MS 996
+// The shortest watchdog period in ms, longer periods double it up to 9 times
+#define WATCHDOG_MIN_MS 16
+#endif
+
+#if defined(RTOS_USE_ARDUINO) && defined(RTOS_TICKLESS)
+// The Arduino core keeps millis() and micros() from timer0 overflows
+extern "C" volatile unsigned long timer0_millis;
+extern "C" volatile unsigned long timer0_overflow_count;
+#endif
 
 namespace RTOS {
 namespace Time {
 
-    static volatile i64 timer1_millis = 0;
+    static volatile Time_t timer1_millis = 0;
+
+    #ifdef RTOS_TIME_32
+    // The number of times timer1_millis has wrapped around
+    static volatile u32 timer1_epoch = 0;
+    #endif
+
+    #ifdef RTOS_TICKLESS
+    // The number of milliseconds covered by the current timer1 compare period
+    static volatile u16 timer1_step = 1;
+    #endif
+
+    #if defined(RTOS_DEEP_SLEEP) && defined(RTOS_SLEEP_TIMER2)
+    // The 1/32 ms left over from converting Timer2 ticks to milliseconds
+    static u8 timer2_rest = 0;
+    #endif
+
+    #ifdef RTOS_BUDGET
+    // The millisecond and timer1 count the current task started at, and the
+    // millisecond its budget runs out in
+    static volatile Time_t budget_start = 0;
+    static volatile u16 budget_count = 0;
+    static volatile Time_t budget_end = 0;
+    #endif
+
+    // Advances the clock by `ms`. MUST BE CALLED IN AN ATOMIC BLOCK!
+    static inline void advance(u16 ms) {
+        #ifdef RTOS_TIME_32
+        Time_t before = timer1_millis;
+        timer1_millis = before + ms;
+        if (timer1_millis < before) {
+            timer1_epoch++;
+        }
+        #else
+        timer1_millis += ms;
+        #endif
+    }
+
+    // Reads the clock in whole milliseconds and sets `count` to the timer1 
+    // count into the current millisecond. Accounts for a compare match the 
+    // ISR has not handled yet. MUST BE CALLED IN AN ATOMIC BLOCK!
+    static inline Time_t read(u16 * count) {
+        Time_t time = timer1_millis;
+        #ifdef RTOS_TICKLESS
+        u16 step = timer1_step;
+        #else
+        u16 step = 1;
+        #endif
+        u16 counted = TCNT1;
+        if (TIFR1 & BV(OCF1A)) {
+            // The counter has been cleared since the match, read it again
+            time += step;
+            counted = TCNT1;
+        }
+        #ifdef RTOS_TICKLESS
+        else if (step != 1) {
+            // During a tickless idle the clock is only advanced at the end of
+            // the idle period, so count the milliseconds passed so far
+            u16 millis = counted / (TIMER_COUNT + 1);
+            time += millis;
+            counted -= millis * (TIMER_COUNT + 1);
+        }
+        #endif
+        *count = counted;
+        return time;
+    }
 
     ISR(TIMER1_COMPA_vect) {
-        timer1_millis++;
+        #ifdef RTOS_TICKLESS
+        advance(timer1_step);
+        if (timer1_step != 1) {
+            // Idle period is over, go back to ticking every millisecond
+            OCR1A = TIMER_COUNT;
+            timer1_step = 1;
+        }
+        #else
+        advance(1);
+        #endif
+        #ifdef RTOS_PREEMPT
+        Preempt::schedule();
+        #endif
+    }
+
+    #ifdef RTOS_BUDGET
+    // Matches once a millisecond at the count the budget runs out on, until
+    // the millisecond it runs out in
+    ISR(TIMER1_COMPB_vect) {
+        u16 count;
+        Time_t time = read(&count);
+        if ((Time_Delta_t) (time - budget_end) < 0) {
+            return;
+        }
+        TIMSK1 &= ~BV(OCIE1B);
+        Task_t * task = Registers::current_task;
+        if (task->impl.overruns < 0xFF) {
+            task->impl.overruns++;
+        }
+        i32 elapsed = (i32) (time - budget_start) * 1000 + ((i32) count - budget_count) * TIMER_US;
+        Registers::trace.tag = Error_Overrun;
+        Registers::trace.error.overrun.instance = task->impl.instance;
+        Registers::trace.error.overrun.elapsed  = (u16) min(elapsed, (i32) 0xFFFF);
+        error();
+    }
+    #endif
+
+    #if defined(RTOS_DEEP_SLEEP) && defined(RTOS_SLEEP_TIMER2)
+    // Only used to wake up from power-save
+    ISR(TIMER2_COMPA_vect) {}
+    #elif defined(RTOS_DEEP_SLEEP)
+    static volatile bool watchdog_fired = false;
+
+    // Only used to wake up from power-down
+    ISR(WDT_vect) {
+        watchdog_fired = true;
     }
+    #endif
 
     void init() {
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -22,12 +160,26 @@ namespace Time {
             TCCR1B |= BV(CS11) | BV(CS10); // Scale by 64
             TIMSK1 |= BV(OCIE1A);          // Enable timer compare interrupt
         }
+        #if defined(RTOS_DEEP_SLEEP) && defined(RTOS_SLEEP_TIMER2)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            TIMSK2 = 0x00;                 // Disable interrupts while switching
+            ASSR   = BV(AS2);              // Clock from the external crystal
+            TCNT2  = 0x00;                 // Clear the counter
+            TCCR2A = BV(WGM21);            // Use CTC mode
+            TCCR2B = BV(CS22) | BV(CS20);  // Scale by 128
+        }
+        // Wait for the asynchronous registers to update
+        while (ASSR & (BV(TCN2UB) | BV(TCR2AUB) | BV(TCR2BUB)));
+        #endif
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             timer1_millis = 0;
+            #ifdef RTOS_TIME_32
+            timer1_epoch = 0;
+            #endif
         }
     }
 
-    i64 now() {
+    Time_t now() {
         // Milliseconds are accurate enough (we want to spend as little time
         // being interrupted as possible, more accurate time tracking requires
         // spending time checking the clock.
@@ -38,47 +190,321 @@ namespace Time {
         // We use a signed number so that math transformations of time will 
         // be safe.
 
-        i64 time;
+        Time_t time;
+        u16 count;
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-            time = timer1_millis;
+            time = read(&count);
         }
         
         return time;
     }
+
+    Time_t now_us() {
+        Time_t time;
+        u16 count;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            time = read(&count);
+        }
+        // A millisecond is TIMER_COUNT + 1 counts, fold the last count into
+        // the one before it so the result never runs ahead of now()
+        if (count >= TIMER_COUNT) {
+            count = TIMER_COUNT - 1;
+        }
+        return time * 1000 + count * TIMER_US;
+    }
+
+    u32 now_us32() {
+        u32 time;
+        u16 count;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            time = (u32) read(&count);
+        }
+        // Folded like now_us so the low bits match
+        if (count >= TIMER_COUNT) {
+            count = TIMER_COUNT - 1;
+        }
+        return time * 1000 + count * TIMER_US;
+    }
+
+    #ifdef RTOS_BUDGET
+    void arm_budget(u16 budget_us) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            u16 count;
+            budget_start = read(&count);
+            // Counted in the same TIMER_COUNT counts a millisecond as now_us
+            if (count >= TIMER_COUNT) {
+                count = TIMER_COUNT - 1;
+            }
+            budget_count = count;
+            u16 end      = count + (budget_us + TIMER_US - 1) / TIMER_US;
+            budget_end   = budget_start + end / TIMER_COUNT;
+            OCR1B        = end % TIMER_COUNT;
+            TIFR1        = BV(OCF1B);   // Clear any stale compare match
+            TIMSK1      |= BV(OCIE1B);  // Enable the budget interrupt
+        }
+    }
+
+    void disarm_budget() {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            TIMSK1 &= ~BV(OCIE1B);
+        }
+    }
+    #endif
+
+    Time_t stamp() {
+        #ifdef RTOS_TIME_US
+            return now_us();
+        #else
+            return now();
+        #endif
+    }
+
+    i64 now64() {
+        #ifdef RTOS_TIME_32
+            u32 millis;
+            u32 epoch;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                millis = now();
+                epoch  = timer1_epoch;
+                if (millis < timer1_millis) {
+                    // now() counted past a wrap the ISR has not handled yet
+                    epoch++;
+                }
+            }
+            return ((i64) epoch << 32) | millis;
+        #else
+            return now();
+        #endif
+    }
     
     void idle_mode() {
         set_sleep_mode(SLEEP_MODE_IDLE);
         sleep_mode();
     }
 
-    void idle(i64 this_time, i64 idle_time) {
+    #if defined(RTOS_USE_ARDUINO) && defined(RTOS_TICKLESS)
+    // Stops the timer0 overflow interrupt, which would otherwise wake the 
+    // processor every 1.024 ms. MUST BE CALLED IN AN ATOMIC BLOCK!
+    static inline void arduino_stop() {
+        TIMSK0 &= ~BV(TOIE0);
+    }
+
+    // Restarts the timer0 overflow interrupt after `ms` milliseconds without
+    // it, correcting millis() and micros() to within a millisecond. MUST BE 
+    // CALLED IN AN ATOMIC BLOCK!
+    static inline void arduino_resume(u16 ms) {
+        timer0_millis += ms;
+        timer0_overflow_count += (u32) ms * 1000 / 1024;
+        TIFR0 = BV(TOV0);
+        TIMSK0 |= BV(TOIE0);
+    }
+    #endif
+
+    #ifdef RTOS_TICKLESS
+    // Sleeps for up to `ms` milliseconds with a single timer1 compare period
+    // instead of waking every millisecond. Returns early if an event is
+    // dispatched, in which case the clock is corrected from the counter.
+    static void tickless_sleep(Time_Delta_t ms) {
+
+        if (ms < 2) {
+            idle_mode();
+            return;
+        }
+        if (ms > TICKLESS_MAX_MS) {
+            ms = TICKLESS_MAX_MS;
+        }
+
+        Time_t before;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            // The counter is still within the current millisecond, so the
+            // compare value is always ahead of it
+            OCR1A = (u16) ms * (TIMER_COUNT + 1) - 1;
+            timer1_step = ms;
+            before = timer1_millis;
+            #ifdef RTOS_USE_ARDUINO
+            arduino_stop();
+            #endif
+        }
+
+        while (timer1_step != 1 && !Event::waiting()) {
+            idle_mode();
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (timer1_step != 1) {
+                if (TIFR1 & BV(OCF1A)) {
+                    // The period ended while we were waking up
+                    advance(timer1_step);
+                    TIFR1 = BV(OCF1A);
+                } else {
+                    u16 count = TCNT1;
+                    u16 millis = count / (TIMER_COUNT + 1);
+                    advance(millis);
+                    TCNT1 = count - millis * (TIMER_COUNT + 1);
+                }
+                OCR1A = TIMER_COUNT;
+                timer1_step = 1;
+            }
+            #ifdef RTOS_USE_ARDUINO
+            arduino_resume((u16) (timer1_millis - before));
+            #endif
+        }
+    }
+    #endif
+
+    #ifdef RTOS_DEEP_SLEEP
+    // Returns the deepest sleep mode that fits `ms` and the latency budget
+    static Sleep_Mode_t sleep_policy(Time_Delta_t ms) {
+        #if defined(RTOS_SLEEP_TIMER2) && POWER_SAVE_LATENCY_MS <= RTOS_SLEEP_LATENCY_MS
+        if (ms >= POWER_SAVE_LATENCY_MS + 4) {
+            return Sleep_Power_Save;
+        }
+        #elif !defined(RTOS_SLEEP_TIMER2) && POWER_DOWN_LATENCY_MS <= RTOS_SLEEP_LATENCY_MS
+        if (ms >= POWER_DOWN_LATENCY_MS + WATCHDOG_MIN_MS) {
+            return Sleep_Power_Down;
+        }
+        #endif
+        return Sleep_Idle;
+    }
+
+    // Sleeps in `mode` for up to `ms` milliseconds, waking up early if an 
+    // interrupt occurs, then advances the clock by the time slept. 
+    static void deep_sleep(Sleep_Mode_t mode, Time_Delta_t ms) {
+
+        ms -= mode == Sleep_Power_Save ? POWER_SAVE_LATENCY_MS : POWER_DOWN_LATENCY_MS;
+        u16 slept = 0;
+
+        #ifdef RTOS_SLEEP_TIMER2
+        u8 ticks = (u8) ((u16) min(ms, TIMER2_MAX_MS) * 32 / 125);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            TCNT2 = 0;
+            OCR2A = ticks - 1;
+        }
+        while (ASSR & (BV(TCN2UB) | BV(OCR2AUB)));
+        TIFR2  = BV(OCF2A);
+        TIMSK2 = BV(OCIE2A);
+        if (!Event::waiting()) {
+            set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+            sleep_mode();
+        }
+        TIMSK2 = 0;
+        // TCNT2 can only be read after one crystal cycle has passed
+        OCR2A = 0xFF;
+        while (ASSR & BV(OCR2AUB));
+        u8 count = TCNT2;
+        if (TIFR2 & BV(OCF2A)) {
+            // CTC cleared the counter on the match, so it has counted the 
+            // oscillator start up since, which is at least STARTUP_MS
+            slept = ticks + count;
+            slept = slept * 125 + timer2_rest;
+            timer2_rest = slept % 32;
+            slept = slept / 32;
+            if (count == 0) {
+                slept += STARTUP_MS;
+            }
+        } else {
+            slept = count * 125 + timer2_rest;
+            timer2_rest = slept % 32;
+            slept = slept / 32;
+        }
+        #else
+        u8 prescale = 0;
+        while ((WATCHDOG_MIN_MS << (prescale + 1)) <= min(ms, (Time_Delta_t) RTOS_SLEEP_WATCHDOG_MS)) {
+            prescale++;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            watchdog_fired = false;
+            wdt_reset();
+            MCUSR &= ~BV(WDRF);
+            WDTCSR = BV(WDCE) | BV(WDE);
+            WDTCSR = BV(WDIE) | (prescale & 0x07) | (prescale & 0x08 ? BV(WDP3) : 0);
+        }
+        bool slept_down = !Event::waiting();
+        if (slept_down) {
+            set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+            sleep_mode();
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            wdt_reset();
+            WDTCSR = BV(WDCE) | BV(WDE);
+            WDTCSR = 0;
+        }
+        // The watchdog has no readable counter, so a sleep ended early by 
+        // another interrupt cannot be measured, half of it is charged
+        if (watchdog_fired) {
+            slept = (WATCHDOG_MIN_MS << prescale) + STARTUP_MS;
+        } else if (slept_down) {
+            slept = (WATCHDOG_MIN_MS << prescale) / 2 + STARTUP_MS;
+        }
+        #endif
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            advance(slept);
+        }
+    }
+    #endif
+
+    void idle(Time_t this_time, Time_Delta_t idle_time) {
+
+        #if defined(RTOS_DEEP_SLEEP) && defined(RTOS_USE_ARDUINO)
+        // The UART stops in deep sleep, let it finish sending first
+        if (sleep_policy(idle_time) != Sleep_Idle) {
+            Serial.flush();
+        }
+        #endif
 
         // Get most accurate idle time
-        i64 now_time = now();
-        idle_time -= (now_time - this_time);
+        Time_t now_time = now();
+        idle_time -= (Time_Delta_t) (now_time - this_time);
         
         // Check if time has already passed by now
         if (idle_time < 1) {
             return;
         }
 
+        #ifdef RTOS_STACK_PAINT
+        Memory::Stack::scan();
+        #endif
+
+        #ifdef RTOS_DEEP_SLEEP
+        Sleep_Mode_t mode = sleep_policy(idle_time);
+        #else
+        Sleep_Mode_t mode = Sleep_Idle;
+        #endif
+
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
             Registers::trace.tag = Mark_Idle;
-            Registers::trace.mark.idle.time = now();
+            Registers::trace.mark.idle.time = stamp();
+            Registers::trace.mark.idle.mode = mode;
             trace();
         }
         #endif
 
         // Delay
-        while(now() - now_time < idle_time && !Registers::events) {
+        Time_Delta_t idled;
+        while((idled = (Time_Delta_t) (now() - now_time)) < idle_time && !Event::waiting()) {
+            #ifdef RTOS_DEEP_SLEEP
+            // Fall back to idle once the rest of the period is too short
+            if (mode != Sleep_Idle && sleep_policy(idle_time - idled) == mode) {
+                deep_sleep(mode, idle_time - idled);
+                continue;
+            }
+            #endif
+            #ifdef RTOS_TICKLESS
+            tickless_sleep(idle_time - idled);
+            #else
             idle_mode();
+            #endif
         }
 
         #ifdef RTOS_TRACE
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            Time_Delta_t latency = (Time_Delta_t) (now() - now_time) - idle_time;
             RTOS::Registers::trace.tag = Mark_Wake;
-            RTOS::Registers::trace.mark.wake.time = now();
+            RTOS::Registers::trace.mark.wake.time = stamp();
+            RTOS::Registers::trace.mark.wake.mode = mode;
+            RTOS::Registers::trace.mark.wake.latency = latency > 0 ? latency : 0;
             trace();
         }
         #endif
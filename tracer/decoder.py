@@ -3,10 +3,12 @@ from struct        import unpack, calcsize
 from mekpie.record import RecordClass
 
 BYTE_ORDER   = '='
+BUCKETS      = 8 # TASK_HISTOGRAM_BUCKETS
 TAG_NAMES    = [
     'Def_Task',
     'Def_Event',
     'Def_Alloc',
+    'Def_Queue',
     'Mark_Init',
     'Mark_Halt',
     'Mark_Start',
@@ -14,45 +16,70 @@ TAG_NAMES    = [
     'Mark_Event',
     'Mark_Idle',
     'Mark_Wake',
+    'Mark_Admit',
+    'Mark_Histogram',
+    'Mark_Full',
+    'Mark_Exhausted',
+    'Mark_Heap',
+    'Mark_Stack',
     'Error_Max_Event',
     'Error_Undefined_Event',
     'Error_Max_Alloc',
     'Error_Max_Pool',
     'Error_Null_Pool',
+    'Error_Max_Heap',
+    'Error_Max_Scratch',
     'Error_Max_Task',
     'Error_Null_Task',
     'Error_Invalid_Task',
     'Error_Duplicate_Event',
     'Error_Missed',
+    'Error_Deadline',
+    'Error_Overload',
+    'Error_Overrun',
     'Debug_Message',
 ]
 TAG_FIELDS = [
     ['handle', 'instance'], # Def_Task
     ['handle', 'event'],    # Def_Event
     ['handle', 'bytes'],    # Def_Alloc
-    ['time', 'heap'],       # Mark_Init
+    ['handle', 'queue'],    # Def_Queue
+    ['time', 'heap', 'resolution', 'latency'], # Mark_Init
     ['time'],               # Mark_Halt
-    ['time', 'instance'],   # Mark_Start
-    ['time', 'instance'],   # Mark_Stop
+    ['time', 'instance', 'latency'], # Mark_Start
+    ['time', 'instance', 'scratch'], # Mark_Stop
     ['time', 'event'],      # Mark_Event
-    ['time'],               # Mark_Idle
-    ['time'],               # Mark_Wake
+    ['time', 'mode'],       # Mark_Idle
+    ['time', 'mode', 'latency'], # Mark_Wake
+    ['time', 'instance', 'result', 'utilization', 'cost'], # Mark_Admit
+    ['time', 'instance'] + [f'bucket{i}' for i in range(BUCKETS)], # Mark_Histogram
+    ['time', 'queue'],      # Mark_Full
+    ['time', 'debt'],       # Mark_Exhausted
+    ['time', 'bytes', 'available', 'fragmentation'], # Mark_Heap
+    ['time', 'watermark', 'free'], # Mark_Stack
     [],                     # Error_Max_Event
     ['event'],              # Error_Undefined_Event
     [],                     # Error_Max_Alloc
     [],                     # Error_Max_Pool
     [],                     # Error_Null_Pool
+    ['bytes'],              # Error_Max_Heap
+    ['bytes'],              # Error_Max_Scratch
     [],                     # Error_Max_Task
     [],                     # Error_Null_Task
     [],                     # Error_Invalid_Task
     ['event'],              # Error_Duplicate_Event
     ['instance'],           # Error_Missed
+    ['instance'],           # Error_Deadline
+    ['instance', 'utilization'], # Error_Overload
+    ['instance', 'elapsed'], # Error_Overrun
     ['message'],             # Debug_Message
 ]
 
 sizeof_trace = None 
 tag_format   = None
 formats      = None
+time_scale   = 1 # Milliseconds per unit of trace time
+latency      = False # Whether Mark_Start reports latency (RTOS_LATCH)
 
 def init_trace(tag_name, fields):
     field_names = ['name', 'tag'] + TAG_FIELDS[fields[0]]
@@ -65,29 +92,44 @@ def init_decoder(event_bytes):
     sizeof_trace = max(
         calcsize(f'{BYTE_ORDER}HQ{E}'), 
         calcsize(f'{BYTE_ORDER}HQH'),
+        calcsize(f'{BYTE_ORDER}HQBBHH'),
+        calcsize(f'{BYTE_ORDER}HQhHH'),
+        calcsize(f'{BYTE_ORDER}HQB{BUCKETS}B'),
     ) 
     tag_format = f'{BYTE_ORDER}H'
     formats = [
         f'{BYTE_ORDER}HHB',   # Def_Task
         f'{BYTE_ORDER}HH{E}', # Def_Event
         f'{BYTE_ORDER}HHH',   # Def_Alloc
-        f'{BYTE_ORDER}HQH',   # Mark_Init
+        f'{BYTE_ORDER}HHB',   # Def_Queue
+        f'{BYTE_ORDER}HQHHB', # Mark_Init
         f'{BYTE_ORDER}HQ',    # Mark_Halt
-        f'{BYTE_ORDER}HQB',   # Mark_Start
-        f'{BYTE_ORDER}HQB',   # Mark_Stop
+        f'{BYTE_ORDER}HQBH',  # Mark_Start
+        f'{BYTE_ORDER}HQBH',  # Mark_Stop
         f'{BYTE_ORDER}HQ{E}', # Mark_Event
-        f'{BYTE_ORDER}HQ',    # Mark_Idle
-        f'{BYTE_ORDER}HQ',    # Mark_Wake
+        f'{BYTE_ORDER}HQB',   # Mark_Idle
+        f'{BYTE_ORDER}HQBH',  # Mark_Wake
+        f'{BYTE_ORDER}HQBBHH', # Mark_Admit
+        f'{BYTE_ORDER}HQB{BUCKETS}B', # Mark_Histogram
+        f'{BYTE_ORDER}HQB',   # Mark_Full
+        f'{BYTE_ORDER}HQH',   # Mark_Exhausted
+        f'{BYTE_ORDER}HQhHH', # Mark_Heap
+        f'{BYTE_ORDER}HQHH',  # Mark_Stack
         f'{BYTE_ORDER}H',     # Error_Max_Event
         f'{BYTE_ORDER}H{E}',  # Error_Undefined_Event
         f'{BYTE_ORDER}H',     # Error_Max_Alloc
         f'{BYTE_ORDER}H',     # Error_Max_Pool
         f'{BYTE_ORDER}H',     # Error_Null_Pool
+        f'{BYTE_ORDER}HH',    # Error_Max_Heap
+        f'{BYTE_ORDER}HH',    # Error_Max_Scratch
         f'{BYTE_ORDER}H',     # Error_Max_Task
         f'{BYTE_ORDER}H',     # Error_Null_Task
         f'{BYTE_ORDER}HB',    # Error_Invalid_Task
         f'{BYTE_ORDER}H{E}',  # Error_Duplicate_Event
         f'{BYTE_ORDER}HB',    # Error_Missed
+        f'{BYTE_ORDER}HB',    # Error_Deadline
+        f'{BYTE_ORDER}HBH',   # Error_Overload
+        f'{BYTE_ORDER}HBH',   # Error_Overrun
         f'{BYTE_ORDER}H',     # Debug_Message
     ]
     print(f'Initialized decoder - (sizeof trace: {sizeof_trace} sizeof event: {sizeof_event})', file=stderr)
@@ -101,6 +143,7 @@ def decode_cstring(serial):
     return buffer
 
 def decode_trace(serial):
+    global time_scale, latency
     if serial.in_waiting >= sizeof_trace:
         trace_bytes = serial.read(sizeof_trace)
         tag_bytes   = trace_bytes[:2]
@@ -108,6 +151,15 @@ def decode_trace(serial):
         tag_name    = TAG_NAMES[tag]
         byte_foramt = formats[tag]
         fields = unpack(byte_foramt, trace_bytes[:calcsize(byte_foramt)])
+        # Report all times in milliseconds
+        if tag_name == 'Mark_Init':
+            time_scale = fields[3] / 1000
+            latency    = bool(fields[4])
+        # Without RTOS_LATCH the latency bytes are left over from other traces
+        if tag_name == 'Mark_Start' and not latency:
+            fields = fields[:-1]
+        if tag_name.startswith('Mark'):
+            fields = (fields[0], fields[1] * time_scale, *fields[2:])
         # Check if we need to read the handler
         if tag_name.startswith('Def') or tag_name == 'Debug_Message':
             fields = (fields[0], decode_cstring(serial), *fields[2:])